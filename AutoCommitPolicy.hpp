@@ -0,0 +1,266 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file AutoCommitPolicy.hpp
+ *	\brief Decides when the posterior is decisive enough to commit to an intention without asking
+ *	\author	Kester Duncan
+ */
+#ifndef __AUTO_COMMIT_POLICY_H__
+#define __AUTO_COMMIT_POLICY_H__
+
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <deque>
+#include <set>
+#include <algorithm>
+#include <functional>
+
+
+namespace oar {
+
+
+/**
+ * \brief Decides when the top intention of a scene is probable enough to be acted upon
+ * without asking the user, who then only has to intervene if it is wrong
+ *
+ * The confidence of a scene is either the posterior of its top intention or the margin
+ * of the top intention over the runner-up. Every session records its confidence along
+ * with whether the top intention turned out to be the user's, and the commit threshold
+ * is the lowest confidence above which the recorded false-commit rate stays within the
+ * target. Until enough sessions have been recorded, the initial threshold is used.
+ * Only the most recent sessions are kept, so that the threshold follows the user and
+ * learning it takes the same time however long the recognizer has been in use.
+ */
+class AutoCommitPolicy {
+public:
+	/// Measure of how decisive a posterior is
+	enum ConfidenceMeasure {
+		TOP_POSTERIOR,		///< Posterior of the top intention
+		TOP_MARGIN			///< Posterior of the top intention minus that of the runner-up
+	};
+
+	/**
+	 * \brief Constructs a policy that targets the false-commit rate \c targetRate
+	 * \param measure The confidence measure compared against the threshold
+	 * \param targetRate The highest acceptable rate of commits to the wrong intention
+	 * \param initialThreshold Threshold used until \c minSupport sessions have been recorded
+	 * \param minSupport Smallest number of recorded sessions the threshold is learned from
+	 * \param maxHistory Largest number of recent sessions the threshold is learned from
+	 */
+	AutoCommitPolicy(const ConfidenceMeasure& measure = TOP_POSTERIOR, const double& targetRate = 0.05,
+			const double& initialThreshold = 0.95, const size_t& minSupport = 10,
+			const size_t& maxHistory = 1000) :
+		measure(measure), targetRate(targetRate), initialThreshold(initialThreshold),
+		minSupport(minSupport), maxHistory(std::max(maxHistory, minSupport)), threshold(initialThreshold),
+		numCommits(0), numFalseCommits(0) {}
+
+	/**
+	 * \brief Computes the confidence of a posterior from the probabilities of its top two
+	 * intentions (\c runnerUp is 0 if there is only one)
+	 */
+	double confidence(const double& top, const double& runnerUp) const {
+		return (measure == TOP_MARGIN) ? (top - runnerUp) : top;
+	}
+
+	/// Indicates whether to commit to the top intention of a scene with confidence \c c
+	bool shouldCommit(const double& c) const {
+		return (c >= threshold);
+	}
+
+	/**
+	 * \brief Records the outcome of a session
+	 * \param c The confidence of the scene
+	 * \param topWasCorrect Whether the top intention was the user's intention
+	 * \param committed Whether the recognizer committed to the top intention
+	 */
+	void record(const double& c, const bool& topWasCorrect, const bool& committed) {
+		addOutcome(Outcome(c, topWasCorrect));
+
+		if (committed) {
+			numCommits++;
+			if (!topWasCorrect) {
+				numFalseCommits++;
+			}
+		}
+
+		learnThreshold();
+	}
+
+	/// Current commit threshold
+	double getThreshold() const {
+		return threshold;
+	}
+
+	/// Number of commits made so far
+	size_t getNumCommits() const {
+		return numCommits;
+	}
+
+	/// Number of commits to an intention that the user rejected
+	size_t getNumFalseCommits() const {
+		return numFalseCommits;
+	}
+
+	/// Fraction of commits that the user rejected
+	double getFalseCommitRate() const {
+		return (numCommits == 0) ? 0. : static_cast<double>(numFalseCommits) / numCommits;
+	}
+
+	/// Number of recent sessions the threshold is learned from
+	size_t getHistorySize() const {
+		return history.size();
+	}
+
+	/**
+	 * \brief Reads the recorded sessions and commit counts from \c fileName
+	 */
+	void readHistory(const std::string& fileName) {
+		std::ifstream inFile;
+		inFile.open(fileName.c_str(), std::ios::in);
+
+		if (inFile.is_open()) {
+			double c;
+			int correct;
+
+			history.clear();
+			byConfidence.clear();
+			inFile >> numCommits >> numFalseCommits;
+
+			while (inFile >> c >> correct) {
+				addOutcome(Outcome(c, correct != 0));
+			}
+
+			inFile.close();
+			learnThreshold();
+
+		} else {
+			std::cerr << "AutoCommitPolicy: Unable to open file " << fileName << " for reading!\n";
+		}
+	}
+
+	/**
+	 * \brief Writes the recorded sessions and commit counts to \c fileName
+	 */
+	void writeHistory(const std::string& fileName) const {
+		std::ofstream outFile;
+		outFile.open(fileName.c_str(), std::ios::out);
+
+		if (outFile.is_open()) {
+			outFile << numCommits << " " << numFalseCommits << std::endl;
+
+			for (size_t i = 0; i < history.size(); i++) {
+				outFile << history[i].first << " " << (history[i].second ? 1 : 0) << std::endl;
+			}
+
+			outFile.close();
+
+		} else {
+			std::cerr << "AutoCommitPolicy: Unable to open file " << fileName << " for writing!\n";
+		}
+	}
+
+
+private:
+	/// Confidence of a session and whether its top intention was correct
+	typedef std::pair<double, bool> Outcome;
+
+	/// Outcomes by decreasing confidence
+	typedef std::multiset<Outcome, std::greater<Outcome> > OutcomeSet;
+
+	ConfidenceMeasure measure;
+	double targetRate;
+	double initialThreshold;
+	size_t minSupport;
+	size_t maxHistory;
+	double threshold;
+	size_t numCommits;
+	size_t numFalseCommits;
+
+	/// Recent sessions, oldest first
+	std::deque<Outcome> history;
+
+	/// The sessions of \c history sorted for learning the threshold
+	OutcomeSet byConfidence;
+
+
+	/// Adds a session to the history, forgetting the oldest one if the history is full
+	void addOutcome(const Outcome& outcome) {
+		history.push_back(outcome);
+		byConfidence.insert(outcome);
+
+		if (history.size() > maxHistory) {
+			byConfidence.erase(byConfidence.find(history.front()));
+			history.pop_front();
+		}
+	}
+
+
+	/**
+	 * \brief Sets the threshold to the lowest recorded confidence above which the rate of
+	 * wrong top intentions is within the target
+	 */
+	void learnThreshold() {
+		if (history.size() < minSupport) {
+			threshold = initialThreshold;
+			return;
+		}
+
+		size_t errors = 0;
+		size_t support = 0;
+		threshold = HUGE_VAL;
+
+		for (OutcomeSet::const_iterator it = byConfidence.begin(); it != byConfidence.end(); ++it) {
+			OutcomeSet::const_iterator next = it;
+			++next;
+
+			if (!it->second) {
+				errors++;
+			}
+			support++;
+
+			const bool lastOfConfidence = (next == byConfidence.end() || next->first < it->first);
+
+			if (lastOfConfidence && support >= minSupport && errors <= targetRate * support) {
+				threshold = it->first;
+			}
+		}
+	}
+
+};
+
+
+} /* oar */
+
+#endif /* __AUTO_COMMIT_POLICY_H__ */
@@ -0,0 +1,215 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file BatchQueryRanker.hpp
+ *	\brief Ranks the queries of many sessions in one call
+ *	\author	Kester Duncan
+ */
+#ifndef __BATCH_QUERY_RANKER_H__
+#define __BATCH_QUERY_RANKER_H__
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <map>
+#include <ctime>
+#include <boost/noncopyable.hpp>
+#include "OARTypes.h"
+#include "Query.hpp"
+#include "ObjectActionMap.h"
+#include "ObjectActionRecognizer.h"
+#include "ThreadPool.hpp"
+
+
+namespace oar {
+
+
+/**
+ * \brief A session to rank: the template map of its user and the scene in front of them
+ */
+struct RankingRequest {
+	std::string mapFileName;		///< Template map of the user
+	ObjectDistanceMap scene;		///< Objects of the scene and their distances from the camera
+
+	RankingRequest() {}
+
+	RankingRequest(const std::string& mapName, const ObjectDistanceMap& sceneObjects) :
+		mapFileName(mapName), scene(sceneObjects) {}
+};
+
+
+/**
+ * \brief The highest ranked queries of a session, best first, with their questions
+ */
+struct RankedQueries {
+	std::vector<Query> queries;				///< Highest ranked queries, best first
+	std::vector<std::string> questions;		///< Question of each query
+	unsigned int seed;						///< Seed that broke the ties between the queries
+
+	RankedQueries() : seed(0) {}
+};
+
+
+/**
+ * \brief Ranks the queries of many sessions in one call
+ *
+ * Each session is run through its own ObjectActionRecognizer (constructNetwork,
+ * generateMarkovBasedQuerySet and getTopQueries), and the sessions are spread over
+ * one thread pool so that the throughput grows with the number of cores. Template
+ * maps are read once per file name and shared by every session that uses them; the
+ * recognizers are built from the loaded maps and never touch the files.
+ *
+ * The ties of session i are broken with the seed <tt>base seed + i</tt>, so that the
+ * sessions of a batch do not share one seed and a batch can be ranked again identically.
+ */
+class BatchQueryRanker : private boost::noncopyable {
+public:
+	/**
+	 * \brief Constructs a ranker that returns the \c headSize best queries of each session,
+	 * using \c numThreads threads (0 uses the hardware concurrency)
+	 */
+	explicit BatchQueryRanker(const size_t& headSize = 5, const size_t& numThreads = 0, const double& learningRate = 1.) :
+		pool(numThreads), headSize(headSize), learningRate(learningRate),
+		baseSeed(static_cast<unsigned int>(time(NULL))) {}
+
+	/// Sets the number of queries returned for each session
+	void setHeadSize(const size_t& k) {
+		headSize = k;
+	}
+
+	/// Gets the number of queries returned for each session
+	size_t getHeadSize() const {
+		return headSize;
+	}
+
+	/// Sets the seed from which the seed of each session is derived
+	void setSeed(const unsigned int& seed) {
+		baseSeed = seed;
+	}
+
+	/// Gets the seed from which the seed of each session is derived
+	unsigned int getSeed() const {
+		return baseSeed;
+	}
+
+	/**
+	 * \brief Ranks the queries of every session in \c requests
+	 * \return The highest ranked queries of each session, in the order of \c requests
+	 */
+	std::vector<RankedQueries> rank(const std::vector<RankingRequest>& requests) {
+		std::vector<const ObjectActionMap*> sessionMaps (requests.size());
+		std::vector<RankedQueries> results (requests.size());
+
+		// Maps are read before the sessions are dispatched so that the cache is never written concurrently
+		for (size_t i = 0; i < requests.size(); i++) {
+			sessionMaps[i] = &loadMap(requests[i].mapFileName);
+		}
+
+		pool.parallelFor(requests.size(), RankKernel(requests, sessionMaps, results, headSize, learningRate, baseSeed));
+
+		return results;
+	}
+
+	/// Forgets the loaded maps, e.g. after they have been updated on disk
+	void clearMapCache() {
+		maps.clear();
+	}
+
+	/// Number of maps loaded
+	size_t getMapCacheSize() const {
+		return maps.size();
+	}
+
+
+private:
+	/// Ranks the queries of one session
+	struct RankKernel {
+		const std::vector<RankingRequest>& requests;
+		const std::vector<const ObjectActionMap*>& sessionMaps;
+		std::vector<RankedQueries>& results;
+		size_t headSize;
+		double learningRate;
+		unsigned int baseSeed;
+
+		RankKernel(const std::vector<RankingRequest>& req, const std::vector<const ObjectActionMap*>& m,
+				std::vector<RankedQueries>& res, const size_t& k, const double& rate, const unsigned int& seed) :
+			requests(req), sessionMaps(m), results(res), headSize(k), learningRate(rate), baseSeed(seed) {}
+
+		void operator() (const size_t& i) const {
+			ObjectActionRecognizer recognizer (*sessionMaps[i], learningRate);
+			RankedQueries& result = results[i];
+			QuestionBuffer question;
+
+			recognizer.setSeed(baseSeed + static_cast<unsigned int>(i));
+			recognizer.constructNetwork(requests[i].scene);
+			recognizer.generateMarkovBasedQuerySet();
+
+			result.seed = recognizer.getSeed();
+			result.queries = recognizer.getTopQueries(headSize);
+			result.questions.reserve(result.queries.size());
+
+			for (size_t j = 0; j < result.queries.size(); j++) {
+				recognizer.renderQuestion(result.queries[j], question);
+				result.questions.push_back(std::string(question.c_str(), question.size()));
+			}
+		}
+	};
+
+	ThreadPool pool;
+	size_t headSize;
+	double learningRate;
+
+	/// Seed of the first session of a batch
+	unsigned int baseSeed;
+
+	/// Loaded template maps, indexed by file name
+	std::map<std::string, ObjectActionMap> maps;
+
+
+	/// Gets the map stored in \c fileName, reading it if it has not been loaded yet
+	const ObjectActionMap& loadMap(const std::string& fileName) {
+		std::map<std::string, ObjectActionMap>::iterator it = maps.find(fileName);
+
+		if (it == maps.end()) {
+			it = maps.insert(std::make_pair(fileName, ObjectActionMap())).first;
+			it->second.readMap(fileName);
+		}
+
+		return it->second;
+	}
+
+};
+
+
+} /* oar */
+
+#endif /* __BATCH_QUERY_RANKER_H__ */
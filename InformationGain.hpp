@@ -0,0 +1,189 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file InformationGain.hpp
+ *	\brief Expected information gain of queries over the intentions of a scene
+ *	\author	Kester Duncan
+ */
+#ifndef __INFORMATION_GAIN_H__
+#define __INFORMATION_GAIN_H__
+
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include "Query.hpp"
+#include "ThreadPool.hpp"
+
+
+namespace oar {
+
+
+/**
+ * \brief Posterior distribution over the <object, action> intentions of a scene
+ *
+ * The intentions are stored as parallel arrays so that the kernels below are simple
+ * loops over contiguous memory.
+ */
+struct IntentionPosterior {
+	std::vector<int> objectIndex;		///< Object node of each intention
+	std::vector<int> actionIndex;		///< Action node of each intention
+	std::vector<double> probability;	///< Normalized probability of each intention
+
+	/**
+	 * \brief Builds the posterior from the full queries in \c querySet
+	 *
+	 * The score of a full query is the belief of its <object, action> factor, so no
+	 * inference is run here.
+	 */
+	void assign(const std::vector<Query>& querySet) {
+		double total = 0.;
+
+		clear();
+
+		for (size_t i = 0; i < querySet.size(); i++) {
+			if (querySet[i].type == FULL_QUERY) {
+				objectIndex.push_back(querySet[i].objectIndex);
+				actionIndex.push_back(querySet[i].actionIndex);
+				probability.push_back(querySet[i].score);
+				total += querySet[i].score;
+			}
+		}
+
+		if (total > 0.) {
+			for (size_t i = 0; i < probability.size(); i++) {
+				probability[i] /= total;
+			}
+		}
+	}
+
+	/// Removes all intentions
+	void clear() {
+		objectIndex.clear();
+		actionIndex.clear();
+		probability.clear();
+	}
+
+	/// Number of intentions
+	size_t size() const {
+		return probability.size();
+	}
+
+	/// Entropy (in bits) of the posterior
+	double entropy() const {
+		double h = 0.;
+
+		for (size_t i = 0; i < probability.size(); i++) {
+			if (probability[i] > 0.) {
+				h -= probability[i] * log(probability[i]);
+			}
+		}
+
+		return h / log(2.0);
+	}
+
+	/**
+	 * \brief Probability that the user answers "yes" to \c q
+	 *
+	 * The loop is branch free: each intention contributes its probability multiplied
+	 * by whether it matches the object and action of the query.
+	 */
+	double answerProbability(const Query& q) const {
+		const size_t n = probability.size();
+		const int objIdx = q.objectIndex;
+		const int actIdx = q.actionIndex;
+		const bool anyObject = !q.hasObject;
+		const bool anyAction = !q.hasAction;
+		double mass = 0.;
+
+		for (size_t i = 0; i < n; i++) {
+			const bool matches = (anyObject || objectIndex[i] == objIdx) && (anyAction || actionIndex[i] == actIdx);
+			mass += static_cast<double>(matches) * probability[i];
+		}
+
+		return mass;
+	}
+
+	/**
+	 * \brief Expected reduction in the entropy over intentions from asking \c q
+	 *
+	 * The answer to a query is a deterministic function of the intention, so
+	 * H(I) - E[H(I | answer)] = H(answer), i.e. the binary entropy of the probability
+	 * of a "yes".
+	 */
+	double informationGain(const Query& q) const {
+		return binaryEntropy(answerProbability(q));
+	}
+
+	/// Entropy (in bits) of a yes/no answer that is "yes" with probability \c p
+	static double binaryEntropy(const double& p) {
+		if (p <= 0. || p >= 1.) {
+			return 0.;
+		}
+		return -(p * log(p) + (1. - p) * log(1. - p)) / log(2.0);
+	}
+};
+
+
+/**
+ * \brief Computes the information gain of each candidate query, in parallel
+ */
+struct InformationGainKernel {
+	const IntentionPosterior* posterior;
+	const std::vector<Query>* candidates;
+	std::vector<double>* gains;
+
+	InformationGainKernel(const IntentionPosterior& p, const std::vector<Query>& c, std::vector<double>& g) :
+		posterior(&p), candidates(&c), gains(&g) {}
+
+	void operator() (const size_t& i) const {
+		(*gains)[i] = posterior->informationGain((*candidates)[i]);
+	}
+};
+
+
+/**
+ * \brief Scores every query in \c candidates by its expected information gain over
+ * the intentions in \c posterior, spreading the candidates across \c pool
+ */
+inline std::vector<double> computeInformationGains(const IntentionPosterior& posterior,
+		const std::vector<Query>& candidates, ThreadPool& pool) {
+
+	std::vector<double> gains(candidates.size(), 0.);
+	pool.parallelFor(candidates.size(), InformationGainKernel(posterior, candidates, gains));
+
+	return gains;
+}
+
+
+} /* oar */
+
+#endif /* __INFORMATION_GAIN_H__ */
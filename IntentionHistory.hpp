@@ -0,0 +1,187 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file IntentionHistory.hpp
+ *	\brief Markov chain over the recently recognized intentions, used as a sequential prior
+ *	\author	Kester Duncan
+ */
+#ifndef __INTENTION_HISTORY_H__
+#define __INTENTION_HISTORY_H__
+
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include "OARTypes.h"
+
+
+namespace oar {
+
+
+/**
+ * \brief Predicts the next intention of the user from the intention recognized last
+ *
+ * Users follow routines, e.g. grasping a cup after pouring from a carton, so the
+ * recognized <object, action> template pairs are kept in a ring buffer of fixed size
+ * together with the counts of the transitions between consecutive entries (a bigram
+ * model). Recording an intention adds its transition and drops the transition of the
+ * entry that falls out of the buffer, which is O(1), so the model follows the recent
+ * routine of the user rather than the whole past.
+ */
+class IntentionHistory {
+public:
+	/// Number of distinct <object, action> template pairs
+	static const size_t NUM_INTENTIONS = NUM_OBJ_CATEGORIES * NUM_ACTIONS;
+
+	/**
+	 * \brief Constructs an empty history that remembers the last \c capacity intentions.
+	 * Unseen transitions get the additive \c smoothing.
+	 */
+	explicit IntentionHistory(const size_t& capacity = 64, const double& smoothing = 1.) :
+		ring(capacity > 2 ? capacity : 2), head(0), count(0),
+		transitions(NUM_INTENTIONS * NUM_INTENTIONS, 0), outgoing(static_cast<size_t>(NUM_INTENTIONS), 0),
+		smoothing(smoothing > 0. ? smoothing : 1.) {}
+
+	/**
+	 * \brief Records that the user's intention was the template object \c objectIdx with
+	 * the template action \c actionIdx
+	 */
+	void record(const size_t& objectIdx, const size_t& actionIdx) {
+		if (objectIdx >= NUM_OBJ_CATEGORIES || actionIdx >= NUM_ACTIONS) {
+			return;
+		}
+
+		const size_t intention = key(objectIdx, actionIdx);
+
+		if (count == ring.size()) {
+			// Forget the transition out of the oldest entry, which is overwritten
+			removeTransition(ring[head], ring[(head + 1) % ring.size()]);
+			addTransition(last(), intention);
+			ring[head] = intention;
+			head = (head + 1) % ring.size();
+
+		} else {
+			if (count > 0) {
+				addTransition(last(), intention);
+			}
+			ring[(head + count) % ring.size()] = intention;
+			count++;
+		}
+	}
+
+	/**
+	 * \brief Gets the factor by which the compatibility of the template pair (\c objectIdx,
+	 * \c actionIdx) is multiplied, i.e. its predicted probability of following the last
+	 * intention relative to a uniform prediction
+	 * \return 1 if nothing is known about what follows the last intention
+	 */
+	double weight(const size_t& objectIdx, const size_t& actionIdx) const {
+		if (count == 0 || objectIdx >= NUM_OBJ_CATEGORIES || actionIdx >= NUM_ACTIONS) {
+			return 1.;
+		}
+
+		const size_t from = last();
+
+		if (outgoing[from] == 0) {
+			return 1.;
+		}
+
+		double predicted = (transitions[from * NUM_INTENTIONS + key(objectIdx, actionIdx)] + smoothing)
+			/ (outgoing[from] + smoothing * NUM_INTENTIONS);
+
+		return predicted * NUM_INTENTIONS;
+	}
+
+	/// Number of intentions remembered
+	size_t size() const {
+		return count;
+	}
+
+	/// Indicates whether no intention is remembered
+	bool empty() const {
+		return (count == 0);
+	}
+
+	/// Forgets every intention
+	void clear() {
+		std::fill(transitions.begin(), transitions.end(), 0);
+		std::fill(outgoing.begin(), outgoing.end(), 0);
+		head = 0;
+		count = 0;
+	}
+
+
+private:
+	/// Recent intentions, oldest at \c head
+	std::vector<size_t> ring;
+
+	/// Position of the oldest intention in \c ring
+	size_t head;
+
+	/// Number of intentions in \c ring
+	size_t count;
+
+	/// Transition counts between consecutive intentions of \c ring, indexed by from * NUM_INTENTIONS + to
+	std::vector<unsigned int> transitions;
+
+	/// Number of transitions out of each intention
+	std::vector<unsigned int> outgoing;
+
+	/// Pseudo-count of every transition
+	double smoothing;
+
+
+	/// Gets the intention of the template pair (\c objectIdx, \c actionIdx)
+	static size_t key(const size_t& objectIdx, const size_t& actionIdx) {
+		return objectIdx * NUM_ACTIONS + actionIdx;
+	}
+
+	/// Gets the most recent intention
+	size_t last() const {
+		return ring[(head + count - 1) % ring.size()];
+	}
+
+	void addTransition(const size_t& from, const size_t& to) {
+		transitions[from * NUM_INTENTIONS + to]++;
+		outgoing[from]++;
+	}
+
+	void removeTransition(const size_t& from, const size_t& to) {
+		transitions[from * NUM_INTENTIONS + to]--;
+		outgoing[from]--;
+	}
+
+};
+
+
+} /* oar */
+
+#endif /* __INTENTION_HISTORY_H__ */
@@ -0,0 +1,210 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file InteractionAnalysis.hpp
+ *	\brief Closed-form number of interactions needed to recognize each intention
+ *	\author	Kester Duncan
+ */
+#ifndef __INTERACTION_ANALYSIS_H__
+#define __INTERACTION_ANALYSIS_H__
+
+#include <cstdlib>
+#include <vector>
+#include <map>
+#include "Query.hpp"
+
+
+namespace oar {
+
+
+/**
+ * \brief Number of interactions needed to recognize each intention of a ranked query set
+ *
+ * The intentions are the full queries of the set, listed in rank order.
+ */
+struct InteractionAnalysis {
+	std::vector<Query> intentions;			///< Full queries of the set, in rank order
+	std::vector<size_t> interactions;		///< Interactions needed when the user wants each intention
+	std::vector<size_t> histogram;			///< Number of intentions needing each interaction count
+	double meanInteractions;				///< Mean over all intentions
+	double expectedInteractions;			///< Mean weighted by the normalized intention scores
+	size_t maxInteractions;					///< Worst case over all intentions
+
+	InteractionAnalysis() : meanInteractions(0.), expectedInteractions(0.), maxInteractions(0) {}
+};
+
+
+namespace detail {
+
+/// Positions in the ranked list, bucketed by object or action node
+typedef std::map<int, std::vector<size_t> > PositionBuckets;
+
+
+/**
+ * \brief Marks the unremoved queries of \c bucket as removed at \c step and empties
+ * the bucket. Each removed query is given its order of removal in \c removalOrder.
+ */
+inline void removeBucket(std::vector<size_t>& bucket, const size_t& step, std::vector<size_t>& removedAt,
+						 std::vector<size_t>& removalOrder) {
+	size_t order = 0;
+
+	for (size_t i = 0; i < bucket.size(); i++) {
+		if (removedAt[bucket[i]] == 0) {
+			removedAt[bucket[i]] = step;
+			removalOrder[bucket[i]] = order;
+			order++;
+		}
+	}
+
+	bucket.clear();
+}
+
+} /* detail */
+
+
+/**
+ * \brief Computes the number of interactions needed to recognize every intention of
+ * \c rankedQueries, which are ordered best first, without simulating a user
+ *
+ * The ranking is assumed to stay fixed while the user answers, i.e. the queries are
+ * asked greedily without a plan, lookahead or group queries; group queries in the set
+ * are ignored. Under the pruning rules of QueryState::applyAnswer, the answers for any
+ * intention are all "no" until the first question that involves it. The list is
+ * therefore walked once while answering "no" to everything, recording the step at
+ * which each full query is asked or pruned:
+ *
+ * - A full query that is asked is recognized at that step.
+ * - A full query pruned by a "no" to its action or object query would have been kept
+ *   by a "yes" to that query instead. Only full queries are left at that point, so
+ *   the intention is recognized after the other full queries pruned at the same step
+ *   that rank above it have been rejected.
+ *
+ * Each query is visited a constant number of times, so the cost is O(n log n) for the
+ * node lookups. Use ObjectActionRecognizer::getQueries() to get the ranked set.
+ */
+inline InteractionAnalysis analyzeInteractions(const std::vector<Query>& rankedQueries) {
+	const size_t n = rankedQueries.size();
+	InteractionAnalysis analysis;
+	detail::PositionBuckets actionQueries, objectQueries, fullByAction, fullByObject;
+	std::vector<size_t> removedAt (n, 0);
+	std::vector<size_t> removalOrder (n, 0);
+	std::vector<char> asked (n, 0);
+
+	for (size_t p = 0; p < n; p++) {
+		const Query& q = rankedQueries[p];
+
+		if (q.type == ACTION_QUERY) {
+			actionQueries[q.actionIndex].push_back(p);
+		} else if (q.type == OBJECT_QUERY) {
+			objectQueries[q.objectIndex].push_back(p);
+		} else if (q.type == FULL_QUERY) {
+			fullByAction[q.actionIndex].push_back(p);
+			fullByObject[q.objectIndex].push_back(p);
+		}
+	}
+
+	/*
+	 * Answer "no" to every query. The query asked at each step is the highest ranked
+	 * one that has not been removed yet.
+	 */
+	size_t step = 0;
+
+	for (size_t p = 0; p < n; p++) {
+		const Query& q = rankedQueries[p];
+
+		if (removedAt[p] != 0 || (q.type != FULL_QUERY && q.type != ACTION_QUERY && q.type != OBJECT_QUERY)) {
+			continue;
+		}
+
+		step++;
+		removedAt[p] = step;
+		asked[p] = 1;
+
+		if (q.type == FULL_QUERY) {
+			detail::removeBucket(actionQueries[q.actionIndex], step, removedAt, removalOrder);
+			detail::removeBucket(objectQueries[q.objectIndex], step, removedAt, removalOrder);
+
+		} else if (q.type == ACTION_QUERY) {
+			detail::removeBucket(actionQueries[q.actionIndex], step, removedAt, removalOrder);
+			detail::removeBucket(fullByAction[q.actionIndex], step, removedAt, removalOrder);
+
+		} else {
+			detail::removeBucket(objectQueries[q.objectIndex], step, removedAt, removalOrder);
+			detail::removeBucket(fullByObject[q.objectIndex], step, removedAt, removalOrder);
+		}
+	}
+
+	double total = 0.;
+	double weightedSum = 0.;
+	double countSum = 0.;
+
+	for (size_t p = 0; p < n; p++) {
+		const Query& q = rankedQueries[p];
+
+		if (q.type != FULL_QUERY) {
+			continue;
+		}
+
+		size_t count = removedAt[p];
+		if (!asked[p]) {
+			count += removalOrder[p] + 1;
+		}
+
+		analysis.intentions.push_back(q);
+		analysis.interactions.push_back(count);
+
+		if (analysis.histogram.size() <= count) {
+			analysis.histogram.resize(count + 1, 0);
+		}
+		analysis.histogram[count]++;
+
+		if (count > analysis.maxInteractions) {
+			analysis.maxInteractions = count;
+		}
+
+		countSum += count;
+		weightedSum += q.score * count;
+		total += q.score;
+	}
+
+	if (!analysis.intentions.empty()) {
+		analysis.meanInteractions = countSum / analysis.intentions.size();
+		analysis.expectedInteractions = (total > 0.) ? (weightedSum / total) : analysis.meanInteractions;
+	}
+
+	return analysis;
+}
+
+
+} /* oar */
+
+#endif /* __INTERACTION_ANALYSIS_H__ */
@@ -69,17 +69,65 @@ ObjectDistanceMap generateCompleteScene() {
 	return sceneObjects;
 }
 
+/**
+ * Converts the template map \c mapName to the binary format, which is then kept by
+ * every later rewrite of the map
+ */
+bool convertToBinaryMap(const string& mapName) {
+	const string tempName = mapName + ".tmp";
+	ObjectActionMap oaMap;
+	boost::system::error_code ec;
+
+	if (!boost::filesystem::exists(mapName)) {
+		cerr << "Unable to find the template map " << mapName << "\n";
+		return false;
+	}
+
+	oaMap.readMap(mapName);
+
+	if (!oaMap.writeMap(tempName, ObjectActionMap::BINARY_MAP)) {
+		boost::filesystem::remove(tempName, ec);
+		return false;
+	}
+
+	boost::filesystem::rename(tempName, mapName, ec);
+
+	if (ec) {
+		cerr << "Unable to replace " << mapName << ": " << ec.message() << "\n";
+		return false;
+	}
+
+	return true;
+}
+
 /**
  * An example of how to use the Object-Action Recognizer for Human Intention Recognition
+ *
+ * Run with --binary-map to convert the template map to the binary format first.
  */
 int main(int argc, char *argv[]) {
 	srand(static_cast<unsigned int>(time(NULL)));
+
+	if (argc > 1 && string(argv[1]) == "--binary-map") {
+		if (!convertToBinaryMap("ObjectActionMap.map")) {
+			return EXIT_FAILURE;
+		}
+		printf("Converted ObjectActionMap.map to the binary format\n");
+	}
+
 	string answer ("No");
 	double learningRateToUse = 10;
 	int inputVal = 0;
 	int numSessionsToLearn = 10;
 	bool randomlySelect = false;
 	std::vector<int> interactionCount;
+	QueryPlanner queryPlanner;
+	AutoCommitPolicy autoCommitPolicy;
+	QueryTypeBandit queryTypeBandit (static_cast<unsigned int>(time(NULL)));
+	IntentionHistory intentionHistory;
+	TemplateJournal templateJournal ("ObjectActionMap.map");
+	SceneCostModel sceneCostModel;
+	QuestionBuffer question;
 
 	std::cout << "-------------------OBJECT-ACTION RECOGNITION-------------------\n";
 
@@ -102,7 +150,16 @@ int main(int argc, char *argv[]) {
 		/**
 		 * Initialize the object-action recognizer
 		 */
-		ObjectActionRecognizer objectActionRecog("ObjectActionMap.map", learningRateToUse);
+		ObjectActionRecognizer objectActionRecog(&templateJournal, learningRateToUse);
+		printf("Query ranking seed: %u\n", objectActionRecog.getSeed());
+		objectActionRecog.setQueryPlanner(&queryPlanner);
+		objectActionRecog.setUseGroupQueries(true);
+		objectActionRecog.setAutoCommitPolicy(&autoCommitPolicy);
+		objectActionRecog.setQueryTypeBandit(&queryTypeBandit);
+		objectActionRecog.setLatencyBudget(250.);
+		objectActionRecog.setSceneCostModel(&sceneCostModel);
+		objectActionRecog.setNegativeLearningRate(0.05);
+		objectActionRecog.setIntentionHistory(&intentionHistory);
 
 
 
@@ -117,19 +174,44 @@ int main(int argc, char *argv[]) {
 		 * Generate the query set to be used
 		 */
 		objectActionRecog.generateMarkovBasedQuerySet();
+		printf("Queries scored by %s\n", ObjectActionRecognizer::getScoringTierName(objectActionRecog.getScoringTier()));
 			
 		int numInteractions = 0;
 		bool choice = false;
+		bool recognized = false;
+
+		/**
+		 * Act on a decisive posterior without asking; the user only intervenes if it is wrong
+		 */
+		if (objectActionRecog.tryAutoCommit()) {
+			objectActionRecog.renderQuestion(objectActionRecog.getCurrentQuery(), question);
+			cout << "Committing to: " << question << " (enter 0 to stop it): ";
+
+			int num;
+			cin >> num;
 
-		do {			
+			recognized = objectActionRecog.confirmCommit(num != 0);
+
+			if (!recognized) {
+				numInteractions++;
+			}
+		}
+
+		while (!recognized) {			
 			objectActionRecog.selectQuery();			
 
-			if (objectActionRecog.getQueries().size() == 0) {
+			if (objectActionRecog.getNumQueries() == 0) {
 				cout << "You have exhausted all possible actions based on your selections!\n";
 				break;
 			}
 			
-			cout << objectActionRecog.getCurrentQuery().question << ": ";
+			objectActionRecog.renderQuestion(objectActionRecog.getCurrentQuery(), question);
+			cout << question << ": ";
+
+			/**
+			 * Prepare the outcomes of both answers while waiting for the user
+			 */
+			objectActionRecog.speculate();
 
 			int num;
 			cin >> num;
@@ -137,7 +219,8 @@ int main(int argc, char *argv[]) {
 			(num == 1) ? choice = true : choice = false;
 			numInteractions++;		
 
-		} while (!objectActionRecog.evaluate(choice));
+			recognized = objectActionRecog.evaluate(choice);
+		}
 
 		printf("+---------------------------------------+\n");
 
@@ -172,6 +255,9 @@ int main(int argc, char *argv[]) {
 	}
 	OARUtils::resetTextColor();
 	printf("]\n");
+
+	printf(" Auto-commits: %lu, false-commit rate: %.2f\n", (unsigned long) autoCommitPolicy.getNumCommits(),
+		autoCommitPolicy.getFalseCommitRate());
 	
 	cout << "Done!\n";
 	cin.get();
@@ -19,6 +19,7 @@
 #include "ObjectActionRecognizer.h"
 #include "OARTestSequencer.h"
 #include "OARUtils.hpp"
+#include "InteractionAnalysis.hpp"
 
 using namespace std;
 using namespace dai;
@@ -60,7 +61,13 @@ int main(int argc, char *argv[]) {
 	outputFile << desiredActionName << "-" << desiredObjectName << " ";
 	cout << desiredActionName << "-" << desiredObjectName << " ";
 
-	ObjectActionRecognizer objectActionRecog("TestObjectActionMap.map");
+	/*
+	 * The map is loaded once and handed to the recognizer, so that reinitialize() keeps
+	 * what was learned in the previous scenes instead of reading the file again
+	 */
+	ObjectActionMap testMap;
+	testMap.readMap("TestObjectActionMap.map");
+	ObjectActionRecognizer objectActionRecog(testMap);
 
 	for (unsigned int i = 0; i < mapList.size(); i++) {
 		objectActionRecog.reinitialize();
@@ -70,37 +77,31 @@ int main(int argc, char *argv[]) {
 		objectActionRecog.generateCountBasedQuerySet();
 
 		int numInteractions = 0;
-		bool choose = false;
 
 		outputFile << (i + 1) << " ";
 
-		do {
-			if (objectActionRecog.getQueries().size() == 0) {
-				cout << "You have exhausted all possible actions based on your selections!\n";
-				break;
-			}
+		/*
+		 * The number of interactions is computed from the ranked query set instead of
+		 * simulating a user answering every query
+		 */
+		InteractionAnalysis analysis = analyzeInteractions(objectActionRecog.getQueries());
 
-			objectActionRecog.selectQuery();
-			Query query = objectActionRecog.getCurrentQuery();
+		for (size_t k = 0; k < analysis.intentions.size(); k++) {
+			const string& objectName = objectActionRecog.getQueryNames().objectName(analysis.intentions[k]);
+			const string& actionName = objectActionRecog.getQueryNames().actionName(analysis.intentions[k]);
 
-			// Determine whether to respond +vely or -vely to this query
-			if (query.type == FULL_QUERY) {
-				(query.objectName.compare(desiredObjectName) == 0 && query.actionName.compare(desiredActionName) == 0) ? choose = true : choose = false;
-			}
-			else if (query.type == OBJECT_QUERY) {
-				(query.objectName.compare(desiredObjectName) == 0) ? choose = true : choose = false;
-			}
-			else if (query.type == ACTION_QUERY) {
-				(query.actionName.compare(desiredActionName) == 0) ? choose = true : choose = false;
-			}
-			else {
-				cout << "Error encountered: UNKNOWN QUERY TYPE\n";
+			if (objectName.compare(desiredObjectName) == 0 && actionName.compare(desiredActionName) == 0) {
+				numInteractions = static_cast<int>(analysis.interactions[k]);
 
+				// Learn from the recognition, as the user would have confirmed it; the next reinitialize() applies it
+				objectActionRecog.confirmIntention(analysis.intentions[k]);
+				break;
 			}
+		}
 
-			numInteractions++;
-
-		} while (!objectActionRecog.evaluate(choose));
+		if (numInteractions == 0) {
+			cout << "The desired intention is not part of scene " << (i + 1) << "!\n";
+		}
 
 		interactionCount.push_back(numInteractions);
 		//objectActionRecog.writeTemplates();
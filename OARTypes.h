@@ -98,12 +98,22 @@ enum Action {
 };
 
 
+/// Set of actions, one bit per Action
+typedef unsigned char ActionMask;
+
+
+/// Gets the bit of \c action in an ActionMask
+inline ActionMask actionBit(const size_t& action) {
+	return static_cast<ActionMask>(1u << action);
+}
+
+
 /**
  * \brief Represents a mapping of an object enum to its string representation
  */
 struct ObjectName {
 	std::string operator() (const Object& object) {
-		static std::string objectName;
+		std::string objectName;
 
 		switch(object) {
 		case BOTTLE:
@@ -154,7 +164,7 @@ struct ObjectName {
  */
 struct ActionName {
 	std::string operator() (const Action& action) {
-		static std::string actionName;
+		std::string actionName;
 
 		switch(action) {
 		case DRINK:
@@ -290,9 +300,21 @@ struct ObjectTemplateProperties {
 	std::string name;
 	std::string fileName;
 	std::vector<Action> actions;
+	ActionMask actionMask;			///< The actions afforded by the category, one bit per action
 	dai::FactorGraph compats;
 
-	ObjectTemplateProperties() : index(0), name(), fileName() {}
+	ObjectTemplateProperties() : index(0), name(), fileName(), actionMask(0) {}
+
+	/// Adds \c action to the actions afforded by the category
+	void addAction(const Action& action) {
+		actions.push_back(action);
+		actionMask |= actionBit(action);
+	}
+
+	/// Determines whether the category affords \c action
+	bool affords(const size_t& action) const {
+		return (actionMask & actionBit(action)) != 0;
+	}
 
 };
 
@@ -344,6 +366,27 @@ typedef std::map<size_t, std::string> NameMap;
 typedef std::vector<dai::Factor> FactorList;
 
 
+/// Labels of the object and action nodes that an <object, action> factor connects
+struct FactorEndpoints {
+	/// Object node label, or -1 if the factor is not an <object, action> factor
+	int objectLabel;
+
+	/// Action node label, or -1 if the factor is not an <object, action> factor
+	int actionLabel;
+
+	FactorEndpoints(const int& objLabel = -1, const int& actLabel = -1) : objectLabel(objLabel), actionLabel(actLabel) {}
+
+	/// Indicates whether the factor relates an object to an action
+	bool isRelation() const {
+		return (objectLabel >= 0 && actionLabel >= 0);
+	}
+};
+
+
+/// Maps a factor index to the nodes it connects
+typedef std::vector<FactorEndpoints> FactorEndpointList;
+
+
 
 /// The number of object actions this system handles
 const size_t NUM_ACTIONS = 7;			
@@ -0,0 +1,957 @@
+/*
+ * \file OARUnitTests.cpp
+ * \brief Focused checks of the components of the recognizer. Enable instead of
+ * OARMain.cpp to run them.
+ */
+#if 0
+
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+
+#include "QueryHeap.hpp"
+#include "QueryStream.hpp"
+#include "QueryState.hpp"
+#include "InteractionAnalysis.hpp"
+#include "IntentionHistory.hpp"
+#include "ObjectActionMap.h"
+#include "TemplateUpdateBuffer.hpp"
+#include "TemplateJournal.hpp"
+#include "QueryRanking.hpp"
+#include "AutoCommitPolicy.hpp"
+#include "QueryPlanner.h"
+#include "SceneCostModel.hpp"
+#include "QueryTypeBandit.hpp"
+#include "ObjectActionCountMap.hpp"
+
+using namespace std;
+using namespace oar;
+
+
+/// Number of failed checks
+static int numFailures = 0;
+
+#define CHECK(condition) \
+	if (!(condition)) { \
+		printf("  FAILED at line %d: %s\n", __LINE__, #condition); \
+		numFailures++; \
+	}
+
+
+/// Determines whether two query lists hold the same queries in the same order
+bool sameOrder(const vector<Query>& a, const vector<Query>& b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i].index != b[i].index) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/// Creates a query set of \c n queries of random types and scores, with distinct tie-break keys
+vector<Query> randomQuerySet(const int& n) {
+	vector<Query> querySet;
+
+	for (int i = 0; i < n; i++) {
+		Query q (i, (rand() % 5) / 4., rand() % 4, rand() % 4, -1, -1);
+		q.type = static_cast<QueryType>(rand() % 4);
+		q.rankScore = rand() % 5;
+		q.tieBreak = i;
+		querySet.push_back(q);
+	}
+
+	return querySet;
+}
+
+
+/// Generates the query set of a scene with random scores, in which every intention is possible
+vector<Query> randomScene(const int& numObjects, const int& numActions) {
+	vector<Query> querySet;
+	int queryIdx = 0;
+
+	for (int a = 0; a < numActions; a++) {
+		Query q (queryIdx++, 0.1 * (rand() % 10), -1, 100 + a, -1, -1);
+		q.type = ACTION_QUERY;
+		querySet.push_back(q);
+	}
+	for (int o = 0; o < numObjects; o++) {
+		Query q (queryIdx++, 0.1 * (rand() % 10), o, -1, -1, -1);
+		q.type = OBJECT_QUERY;
+		querySet.push_back(q);
+	}
+	for (int o = 0; o < numObjects; o++) {
+		for (int a = 0; a < numActions; a++) {
+			Query q (queryIdx++, 0.01 + 0.1 * (rand() % 10), o, 100 + a, -1, -1);
+			q.type = FULL_QUERY;
+			querySet.push_back(q);
+		}
+	}
+
+	return querySet;
+}
+
+
+/// Checks that every step of \c policy asks a query of \c querySet and leads to steps of the policy
+bool isWellFormed(const QueryPolicy& policy, const vector<Query>& querySet) {
+	for (size_t i = 0; i < policy.nodes.size(); i++) {
+		const PolicyNode& node = policy.nodes[i];
+		bool found = false;
+
+		for (size_t j = 0; j < querySet.size(); j++) {
+			found = found || (querySet[j].index == node.queryIndex);
+		}
+		if (!found || node.yes >= static_cast<int>(policy.nodes.size())
+				|| node.no >= static_cast<int>(policy.nodes.size())) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/**
+ * QueryHeap proposes the queries in the order of the comparator, also after queries
+ * are removed or added
+ */
+void testQueryHeap() {
+	printf("Query heap\n");
+
+	for (int trial = 0; trial < 200; trial++) {
+		vector<Query> querySet = randomQuerySet(1 + rand() % 40);
+		vector<Query> sorted (querySet);
+		QueryHeap heap;
+
+		sort(sorted.begin(), sorted.end(), QueryComparator());
+		heap.assign(querySet, QueryComparator());
+
+		CHECK(heap.size() == querySet.size());
+		CHECK(sameOrder(heap.ranked(), sorted));
+		CHECK(sameOrder(heap.peek(3), vector<Query>(sorted.begin(), sorted.begin() + min<size_t>(3, sorted.size()))));
+		CHECK(heap.top().index == sorted[0].index);
+
+		// Removal keeps the order of the remaining queries
+		vector<Query> kept;
+		for (size_t i = 0; i < sorted.size(); i++) {
+			if (!InvolvesAction(1)(sorted[i])) {
+				kept.push_back(sorted[i]);
+			}
+		}
+		CHECK(heap.removeIf(InvolvesAction(1)) == sorted.size() - kept.size());
+		CHECK(sameOrder(heap.ranked(), kept));
+
+		// A pushed query is ranked with the others
+		Query groupQuery (static_cast<int>(querySet.size()), 1.);
+		groupQuery.type = GROUP_QUERY;
+		groupQuery.rankScore = 10;
+		heap.push(groupQuery);
+		CHECK(heap.top().index == groupQuery.index);
+
+		heap.pop();
+		for (size_t i = 0; i < kept.size() && !heap.empty(); i++) {
+			CHECK(heap.top().index == kept[i].index);
+			heap.pop();
+		}
+		CHECK(heap.empty());
+	}
+
+	// Without an ordering, queries are proposed in the order they were given
+	vector<Query> querySet = randomQuerySet(10);
+	QueryHeap unordered;
+	unordered.assign(querySet);
+	CHECK(sameOrder(unordered.ranked(), querySet));
+}
+
+
+/**
+ * QueryStream merges its per-type heaps into the order of a single QueryHeap, and
+ * ranks the queries of one type on their own
+ */
+void testQueryStream() {
+	printf("Query stream\n");
+
+	for (int trial = 0; trial < 200; trial++) {
+		vector<Query> querySet = randomQuerySet(1 + rand() % 40);
+		QueryHeap heap;
+		QueryStream stream;
+
+		heap.assign(querySet, QueryComparator());
+		stream.assign(querySet, QueryComparator());
+
+		CHECK(sameOrder(stream.ranked(), heap.ranked()));
+		CHECK(sameOrder(stream.peek(3), heap.peek(3)));
+
+		vector<Query> ranked = heap.ranked(), fullQueries;
+		for (size_t i = 0; i < ranked.size(); i++) {
+			if (ranked[i].type == FULL_QUERY) {
+				fullQueries.push_back(ranked[i]);
+			}
+		}
+		CHECK(sameOrder(stream.ranked(FULL_QUERY), fullQueries));
+		CHECK(sameOrder(stream.peek(2, FULL_QUERY),
+			vector<Query>(fullQueries.begin(), fullQueries.begin() + min<size_t>(2, fullQueries.size()))));
+
+		heap.removeIf(InvolvesAction(1));
+		stream.removeIf(InvolvesAction(1));
+		CHECK(heap.size() == stream.size());
+		CHECK(sameOrder(stream.ranked(), heap.ranked()));
+
+		Query groupQuery (static_cast<int>(querySet.size()), 1.);
+		groupQuery.type = GROUP_QUERY;
+		groupQuery.rankScore = 10;
+		heap.push(groupQuery);
+		stream.push(groupQuery);
+		CHECK(stream.top().index == groupQuery.index);
+
+		while (!heap.empty() && !stream.empty() && heap.top().index == stream.top().index) {
+			heap.pop();
+			stream.pop();
+		}
+		CHECK(heap.empty() && stream.empty());
+	}
+
+	// Without an ordering, queries are proposed in the order they were given
+	vector<Query> querySet = randomQuerySet(10);
+	QueryStream unordered;
+	unordered.assign(querySet);
+	CHECK(sameOrder(unordered.ranked(), querySet));
+}
+
+
+/**
+ * analyzeInteractions gives, for every intention, the number of answers QueryState
+ * takes to recognize it when the user answers truthfully
+ */
+void testInteractionAnalysis() {
+	printf("Interaction analysis\n");
+
+	for (int trial = 0; trial < 100; trial++) {
+		const int numObjects = 1 + rand() % 5;
+		const int numActions = 1 + rand() % 4;
+		vector<Query> querySet = randomScene(numObjects, numActions);
+
+		random_shuffle(querySet.begin(), querySet.end());
+
+		InteractionAnalysis analysis = analyzeInteractions(querySet);
+		CHECK(analysis.intentions.size() == static_cast<size_t>(numObjects * numActions));
+
+		for (size_t k = 0; k < analysis.intentions.size(); k++) {
+			const Query& intention = analysis.intentions[k];
+			const vector<Query> noPlan;
+			QueryState state;
+			size_t numInteractions = 0;
+			bool recognized = false;
+
+			state.assign(querySet);
+
+			while (!recognized && numInteractions <= querySet.size()) {
+				state.select(NULL, noPlan, NULL);
+				numInteractions++;
+
+				const Query& q = state.currentQuery;
+				bool yes = false;
+
+				if (q.type == FULL_QUERY) {
+					yes = (q.index == intention.index);
+				} else if (q.type == ACTION_QUERY) {
+					yes = (q.actionIndex == intention.actionIndex);
+				} else if (q.type == OBJECT_QUERY) {
+					yes = (q.objectIndex == intention.objectIndex);
+				}
+				recognized = state.applyAnswer(yes, NULL);
+			}
+
+			CHECK(recognized);
+			CHECK(analysis.interactions[k] == numInteractions);
+		}
+	}
+}
+
+
+/**
+ * Planned policies are cached by scene and the least recently used one is evicted, while
+ * the policies handed out stay valid
+ */
+void testPlannerCache() {
+	printf("Planner cache\n");
+
+	QueryNameTable names;
+	QueryPlanner planner (5000, 2);
+	vector<Query> a = randomScene(2, 2);
+	vector<Query> b = randomScene(2, 3);
+	vector<Query> c = randomScene(3, 2);
+
+	// The signature depends neither on the order of the queries nor on the scale of the scores
+	vector<Query> shuffled (a);
+	random_shuffle(shuffled.begin(), shuffled.end());
+	for (size_t i = 0; i < shuffled.size(); i++) {
+		shuffled[i].score *= 3.;
+	}
+	CHECK(QueryPlanner::sceneSignature(shuffled, names) == QueryPlanner::sceneSignature(a, names));
+	CHECK(QueryPlanner::sceneSignature(b, names) != QueryPlanner::sceneSignature(a, names));
+
+	QueryPolicyPtr pa = planner.plan(a, names);
+	CHECK(pa->optimal);
+	CHECK(isWellFormed(*pa, a));
+	CHECK(pa->expectedInteractions() >= 1.);
+	CHECK(planner.plan(shuffled, names) == pa);
+	CHECK(planner.getCacheSize() == 1);
+
+	QueryPolicyPtr pb = planner.plan(b, names);
+	CHECK(planner.getCacheSize() == 2);
+
+	// Using a makes b the least recently used scene, which c evicts
+	CHECK(planner.plan(a, names) == pa);
+	planner.plan(c, names);
+	CHECK(planner.getCacheSize() == 2);
+	CHECK(planner.plan(a, names) == pa);
+
+	QueryPolicyPtr replanned = planner.plan(b, names);
+	CHECK(replanned != pb);
+	CHECK(isWellFormed(*pb, b));
+	CHECK(replanned->nodes.size() == pb->nodes.size());
+	CHECK(replanned->expectedInteractions() == pb->expectedInteractions());
+
+	planner.setMaxCacheSize(1);
+	CHECK(planner.getCacheSize() == 1);
+	CHECK(planner.plan(b, names) == replanned);
+
+	planner.clearCache();
+	CHECK(planner.getCacheSize() == 0);
+
+	planner.setMaxCacheSize(0);
+	planner.plan(a, names);
+	CHECK(planner.getCacheSize() == 0);
+}
+
+
+/**
+ * The auto-commit threshold is learned from the recent sessions only, and reads back
+ * from its history file as it was
+ */
+void testAutoCommitPolicy(const boost::filesystem::path& dir) {
+	printf("Auto-commit policy\n");
+
+	AutoCommitPolicy policy (AutoCommitPolicy::TOP_POSTERIOR, 0.1, 0.95, 10, 20);
+	AutoCommitPolicy margin (AutoCommitPolicy::TOP_MARGIN);
+
+	CHECK(fabs(policy.confidence(0.7, 0.2) - 0.7) < 1e-12);
+	CHECK(fabs(margin.confidence(0.7, 0.2) - 0.5) < 1e-12);
+
+	// The initial threshold holds until there is enough support
+	for (int k = 1; k <= 9; k++) {
+		policy.record(0.05 * k, false, false);
+	}
+	CHECK(policy.getThreshold() == 0.95);
+	CHECK(policy.shouldCommit(0.96) && !policy.shouldCommit(0.9));
+
+	// Correct from 0.5 on; one error in 12 sessions is within the target, two in 13 are not
+	for (int k = 10; k <= 20; k++) {
+		policy.record(0.05 * k, true, k == 20);
+	}
+	CHECK(policy.getHistorySize() == 20);
+	CHECK(fabs(policy.getThreshold() - 0.45) < 1e-9);
+	CHECK(policy.getNumCommits() == 1 && policy.getNumFalseCommits() == 0);
+
+	// Wrong at a high confidence: no threshold is safe any more
+	for (int i = 0; i < 20; i++) {
+		policy.record(0.99, false, true);
+	}
+	CHECK(policy.getHistorySize() == 20);
+	CHECK(!policy.shouldCommit(1.));
+	CHECK(policy.getNumFalseCommits() == 20);
+
+	// Once those sessions have left the window they no longer count
+	for (int i = 0; i < 20; i++) {
+		policy.record(0.3, true, false);
+	}
+	CHECK(policy.getHistorySize() == 20);
+	CHECK(fabs(policy.getThreshold() - 0.3) < 1e-12);
+
+	const string historyName = (dir / "autocommit.txt").string();
+	AutoCommitPolicy reread (AutoCommitPolicy::TOP_POSTERIOR, 0.1, 0.95, 10, 20);
+
+	policy.writeHistory(historyName);
+	reread.readHistory(historyName);
+	CHECK(reread.getHistorySize() == 20);
+	CHECK(reread.getThreshold() == policy.getThreshold());
+	CHECK(reread.getNumCommits() == policy.getNumCommits());
+	CHECK(reread.getFalseCommitRate() == policy.getFalseCommitRate());
+}
+
+
+/**
+ * A planner given a deadline stops searching at it, answers with an information-gain
+ * policy for the rest of the tree and does not cache that policy
+ */
+void testPlannerDeadline() {
+	printf("Planner deadline\n");
+
+	QueryNameTable names;
+	QueryPlanner planner (100000000);
+	vector<Query> large = randomScene(12, 8);
+	vector<Query> small = randomScene(2, 2);
+
+	// Far too short to search a scene of 96 intentions
+	QueryPolicyPtr cutShort = planner.plan(large, names, NULL, 0.001);
+	CHECK(!cutShort->optimal);
+	CHECK(!cutShort->nodes.empty());
+	CHECK(cutShort->expectedInteractions() >= 1.);
+	CHECK(isWellFormed(*cutShort, large));
+	CHECK(planner.getCacheSize() == 0);
+
+	QueryPolicyPtr planned = planner.plan(small, names, NULL, 60000.);
+	CHECK(planned->optimal);
+	CHECK(isWellFormed(*planned, small));
+	CHECK(planner.getCacheSize() == 1);
+	CHECK(planner.plan(small, names, NULL, 0.001) == planned);
+}
+
+
+/**
+ * The scoring tier is chosen from the estimated cost of a sweep, which is unknown
+ * until one is measured and then follows the measurements
+ */
+void testSceneCostModel() {
+	printf("Scene cost model\n");
+
+	SceneCostModel model;
+	CHECK(model.estimateSweepMillis(100) == 0.);
+
+	// Nothing to learn from a scene without sweeps or factors
+	model.recordInference(50., 0, 100);
+	model.recordInference(50., 5, 0);
+	CHECK(model.getSweepMillisPerFactor() == 0.);
+
+	model.recordInference(50., 5, 100);
+	CHECK(fabs(model.estimateSweepMillis(100) - 10.) < 1e-9);
+	CHECK(fabs(model.estimateSweepMillis(200) - 20.) < 1e-9);
+
+	// A slower machine raises the estimate gradually
+	model.recordInference(100., 5, 100);
+	CHECK(model.estimateSweepMillis(100) > 10. && model.estimateSweepMillis(100) < 20.);
+
+	for (int i = 0; i < 50; i++) {
+		model.recordInference(100., 5, 100);
+	}
+	CHECK(fabs(model.estimateSweepMillis(100) - 20.) < 1e-3);
+
+	vector<double> priors (6, 0.);
+	priors[1 * 3 + 2] = 0.5;
+	model.setTemplatePriors(priors, 3);
+	CHECK(model.hasTemplatePriors());
+	CHECK(model.getTemplatePrior(1, 2) == 0.5);
+	CHECK(model.getTemplatePrior(1, 3) == 0.);
+	CHECK(model.getTemplatePrior(2, 0) == 0.);
+
+	model.invalidateTemplatePriors();
+	CHECK(!model.hasTemplatePriors());
+}
+
+
+/**
+ * The bandit rewards the query types of quickly resolved sessions, draws from the
+ * learned posteriors and weights only the types it learns
+ */
+void testQueryTypeBandit(const boost::filesystem::path& dir) {
+	printf("Query type bandit\n");
+
+	QueryTypeBandit bandit (1);
+
+	CHECK(bandit.context(1) == 0 && bandit.context(2) == 1 && bandit.context(3) == 1);
+	CHECK(bandit.context(4) == 2 && bandit.context(1000000) == 5);
+	CHECK(bandit.getSuccessRate(1, FULL_QUERY) == 0.5);
+	CHECK(bandit.getSuccessRate(1, GROUP_QUERY) == 0.);
+	CHECK(!QueryTypeBandit::isLearned(GROUP_QUERY) && QueryTypeBandit::isLearned(OBJECT_QUERY));
+
+	// A full query that recognized the intention right away earns the whole reward
+	vector<size_t> asked (QueryTypeBandit::NUM_TYPES, 0);
+	asked[FULL_QUERY] = 1;
+	bandit.recordSession(1, asked, 1);
+	CHECK(fabs(bandit.getSuccessRate(1, FULL_QUERY) - 2. / 3.) < 1e-12);
+	CHECK(bandit.getSuccessRate(1, ACTION_QUERY) == 0.5);
+	CHECK(bandit.getSuccessRate(2, FULL_QUERY) == 0.5);
+
+	// Two action queries out of four questions share the reward 1/4
+	asked.assign(QueryTypeBandit::NUM_TYPES, 0);
+	asked[ACTION_QUERY] = 2;
+	asked[FULL_QUERY] = 2;
+	bandit.recordSession(1, asked, 4);
+	CHECK(fabs(bandit.getSuccessRate(1, ACTION_QUERY) - 1.125 / 2.5) < 1e-12);
+
+	// Sessions out of range or without questions are ignored
+	const double fullRate = bandit.getSuccessRate(1, FULL_QUERY);
+	bandit.recordSession(6, asked, 4);
+	bandit.recordSession(1, asked, 0);
+	CHECK(bandit.getSuccessRate(1, FULL_QUERY) == fullRate);
+
+	// Object queries always resolve quickly and action queries never do
+	for (int session = 0; session < 50; session++) {
+		asked.assign(QueryTypeBandit::NUM_TYPES, 0);
+		asked[OBJECT_QUERY] = 1;
+		bandit.recordSession(3, asked, 1);
+
+		asked.assign(QueryTypeBandit::NUM_TYPES, 0);
+		asked[ACTION_QUERY] = 10;
+		bandit.recordSession(3, asked, 10);
+	}
+
+	double objectDraws = 0., actionDraws = 0.;
+	for (int draw = 0; draw < 100; draw++) {
+		vector<double> theta = bandit.sample(3);
+		objectDraws += theta[OBJECT_QUERY];
+		actionDraws += theta[ACTION_QUERY];
+	}
+	CHECK(objectDraws > 90. && actionDraws < 20.);
+
+	vector<Query> querySet = randomScene(2, 2);
+	Query groupQuery (static_cast<int>(querySet.size()), 0.5);
+	groupQuery.type = GROUP_QUERY;
+	querySet.push_back(groupQuery);
+
+	vector<double> theta (QueryTypeBandit::NUM_TYPES, 1.);
+	theta[FULL_QUERY] = 0.5;
+	bandit.weigh(querySet, theta);
+
+	for (size_t i = 0; i < querySet.size(); i++) {
+		const double weight = (querySet[i].type == FULL_QUERY) ? 0.5 : 1.;
+		CHECK(querySet[i].rankScore == Query::quantizeScore(querySet[i].score * weight));
+	}
+
+	const string posteriorName = (dir / "bandit.txt").string();
+	QueryTypeBandit reread;
+
+	bandit.writePosteriors(posteriorName);
+	reread.readPosteriors(posteriorName);
+	CHECK(fabs(reread.getSuccessRate(1, ACTION_QUERY) - bandit.getSuccessRate(1, ACTION_QUERY)) < 1e-5);
+	CHECK(fabs(reread.getSuccessRate(3, OBJECT_QUERY) - bandit.getSuccessRate(3, OBJECT_QUERY)) < 1e-5);
+}
+
+
+/// Checks that the totals of \c counts match the sums of its pair counts
+bool totalsMatchCounts(const ObjectActionCountMap& counts) {
+	size_t total = 0;
+	bool match = true;
+
+	for (size_t o = 0; o < counts.getNumOfObjects(); o++) {
+		size_t objectCount = 0;
+
+		for (size_t a = 0; a < counts.getNumOfActions(); a++) {
+			objectCount += counts.getPairCount(o, a);
+		}
+		match = match && (objectCount == counts.getObjectCount(o));
+		total += objectCount;
+	}
+
+	for (size_t a = 0; a < counts.getNumOfActions(); a++) {
+		size_t actionCount = 0;
+
+		for (size_t o = 0; o < counts.getNumOfObjects(); o++) {
+			actionCount += counts.getPairCount(o, a);
+		}
+		match = match && (actionCount == counts.getActionCount(a));
+	}
+
+	return match && (total == counts.getTotalCount());
+}
+
+
+/**
+ * The running totals of the count map match its pair counts after counting, growing,
+ * shrinking and clearing
+ */
+void testCountMapTotals() {
+	printf("Count map totals\n");
+
+	ObjectActionCountMap counts (3, 2);
+
+	for (int i = 0; i < 500; i++) {
+		counts(rand() % 4, rand() % 3);
+		CHECK(totalsMatchCounts(counts));
+	}
+
+	// Counting beyond the dimensions grew the map
+	CHECK(counts.getNumOfObjects() == 4 && counts.getNumOfActions() == 3);
+	CHECK(counts.getTotalCount() == 500);
+
+	vector<size_t> objectIdxs (1, 1), actionIdxs (1, 2);
+	vector<double> objectProbs, actionProbs;
+	counts.getProbabilities(objectIdxs, actionIdxs, objectProbs, actionProbs);
+	CHECK(objectProbs[0] == counts.getObjectProbability(1));
+	CHECK(actionProbs[0] == counts.getActionProbability(2));
+	CHECK(fabs(objectProbs[0] - counts.getObjectCount(1) / 500.) < 1e-12);
+
+	// Shrinking drops the pairs out of range from the totals
+	const size_t kept = counts.getPairCount(0, 0) + counts.getPairCount(0, 1) + counts.getPairCount(1, 0)
+		+ counts.getPairCount(1, 1);
+	counts.resize(2, 2);
+	CHECK(totalsMatchCounts(counts));
+	CHECK(counts.getTotalCount() == kept);
+	CHECK(counts.getObjectCount(3) == 0 && counts.getPairCount(3, 2) == 0);
+
+	counts.resize(5, 5);
+	CHECK(totalsMatchCounts(counts));
+	CHECK(counts.getTotalCount() == kept);
+
+	counts.clear();
+	CHECK(totalsMatchCounts(counts));
+	CHECK(counts.getTotalCount() == 0 && counts.getObjectProbability(0) == 0.);
+}
+
+
+/**
+ * Once the ring of IntentionHistory wraps around, the weights only reflect the
+ * transitions between the intentions still in the ring
+ */
+void testIntentionHistoryWrapAround() {
+	printf("Intention history wrap-around\n");
+
+	const size_t capacity = 5;
+	IntentionHistory history (capacity);
+	deque<size_t> recent;
+
+	for (int i = 0; i < 200; i++) {
+		const size_t objectIdx = rand() % 3;
+		const size_t actionIdx = rand() % 2;
+
+		history.record(objectIdx, actionIdx);
+		recent.push_back(objectIdx * NUM_ACTIONS + actionIdx);
+		if (recent.size() > capacity) {
+			recent.pop_front();
+		}
+
+		CHECK(history.size() == recent.size());
+
+		// Smoothed bigram estimate over the transitions in the ring, relative to uniform
+		for (size_t o = 0; o < 3; o++) {
+			for (size_t a = 0; a < 2; a++) {
+				double numTransitions = 0., numOutgoing = 0.;
+
+				for (size_t k = 0; k + 1 < recent.size(); k++) {
+					if (recent[k] == recent.back()) {
+						numOutgoing++;
+						if (recent[k + 1] == o * NUM_ACTIONS + a) {
+							numTransitions++;
+						}
+					}
+				}
+
+				const double numIntentions = static_cast<double>(IntentionHistory::NUM_INTENTIONS);
+				const double expected = (numOutgoing == 0.) ? 1.
+					: (numTransitions + 1.) / (numOutgoing + numIntentions) * numIntentions;
+
+				CHECK(fabs(history.weight(o, a) - expected) < 1e-9);
+			}
+		}
+	}
+
+	history.clear();
+	CHECK(history.empty());
+	CHECK(history.weight(0, 0) == 1.);
+}
+
+
+/// Writes a text map of a few <object, action> templates to \c fileName
+void writeTestMap(const string& fileName) {
+	ofstream mapFile (fileName.c_str());
+
+	mapFile << "0 Bottle 0 Drink 0.125 0.125 0.125 0.625\n";
+	mapFile << "0 Bottle 1 Grasp 0.125 0.125 0.125 0.625\n";
+	mapFile << "1 Bowl 1 Grasp 0.125 0.125 0.125 0.625\n";
+	mapFile << "1 Bowl 2 Move 0.25 0.25 0.25 0.25\n";
+}
+
+
+/// Largest difference between the compatibilities of two maps
+double mapDifference(ObjectActionMap& a, ObjectActionMap& b) {
+	double maxDiff = 0.;
+
+	for (size_t o = 0; o < a.getNumOfObjects(); o++) {
+		for (size_t x = 0; x < a.getNumOfActions(); x++) {
+			ObjectActionProperty p = a(o, x);
+			ObjectActionProperty q = b(o, x);
+
+			for (size_t k = 0; k < 4; k++) {
+				maxDiff = max(maxDiff, fabs(p(k) - q(k)));
+			}
+		}
+	}
+
+	return maxDiff;
+}
+
+
+/**
+ * A rejection on the normalized scale lowers a learned pair a little, and rejections
+ * never make it less compatible than the other states of its template
+ */
+void testNegativeUpdates(const boost::filesystem::path& dir) {
+	printf("Negative updates\n");
+
+	const string mapName = (dir / "negative.map").string();
+	ObjectActionMap oaMap;
+
+	writeTestMap(mapName);
+	oaMap.readMap(mapName);
+
+	// Learned as OARMain learns, then rejected once at the rate OARMain uses
+	TemplateUpdateBuffer learned;
+	learned.add(0, 0, 10.);
+	learned.apply(oaMap);
+	const double learnedValue = oaMap(0, 0)(3);
+
+	TemplateUpdateBuffer rejected;
+	rejected.add(0, 0, -0.05);
+	rejected.apply(oaMap);
+	ObjectActionProperty prop = oaMap(0, 0);
+
+	CHECK(prop(3) < learnedValue);
+	CHECK(learnedValue - prop(3) < 0.01);
+	CHECK(prop(3) > 10. * prop(0));
+	CHECK(fabs(prop(0) + prop(1) + prop(2) + prop(3) - 1.) < 1e-9);
+
+	// Repeated rejections of an unlearned pair stop at the other states
+	for (int session = 0; session < 100; session++) {
+		TemplateUpdateBuffer updates;
+		updates.add(0, 1, -0.05);
+		updates.apply(oaMap);
+
+		prop = oaMap(0, 1);
+		CHECK(prop(3) >= prop(0) - 1e-12);
+	}
+	CHECK(fabs(prop(3) - 0.25) < 1e-9);
+}
+
+
+/**
+ * A binary map reads back exactly as it was written, and a damaged one is rejected
+ */
+void testBinaryMapRoundTrip(const boost::filesystem::path& dir) {
+	printf("Binary map round trip\n");
+
+	const string textName = (dir / "roundtrip.map").string();
+	const string binaryName = (dir / "roundtrip.bin").string();
+
+	writeTestMap(textName);
+
+	ObjectActionMap original;
+	original.readMap(textName);
+	original.updateMap(0, 0, 0.3);
+	original.normalizeTemplate(0, 0);
+	CHECK(original.writeMap(binaryName, ObjectActionMap::BINARY_MAP));
+
+	ObjectActionMap loaded;
+	loaded.readMap(binaryName);
+	CHECK(loaded.getFormat() == ObjectActionMap::BINARY_MAP);
+	CHECK(mapDifference(original, loaded) == 0.);
+
+	ObjectActionProperty prop = loaded(1, 2);
+	CHECK(prop.objectName == "Bowl" && prop.actionName == "Move");
+
+	// Maps are written back in the format they were read in
+	CHECK(loaded.writeMap(binaryName));
+	CHECK(ObjectActionMap::detectFormat(binaryName) == ObjectActionMap::BINARY_MAP);
+
+	// Damage a record; the checksum rejects the file and the map is left as it was
+	{
+		fstream binaryFile (binaryName.c_str(), ios::in | ios::out | ios::binary);
+		binaryFile.seekp(100);
+		binaryFile.put('x');
+	}
+
+	ObjectActionMap damaged;
+	damaged.readMap(binaryName);
+	ObjectActionProperty damagedProp = damaged(1, 2);
+	CHECK(damagedProp.objectName.empty());
+}
+
+
+/// Adds the updates of a session, some positive and some negative, to \c updates
+void addSessionUpdates(TemplateUpdateBuffer& updates) {
+	updates.add(0, rand() % 2, 1. + rand() % 3);
+	updates.add(1, 1, -0.05);
+	updates.add(1, 2, 0.5);
+}
+
+
+/**
+ * Loading a map through its journal gives the map that rewriting it after every
+ * session would have given, across compactions, and the map that a recognizer keeps
+ * in memory across sessions
+ */
+void testJournalReplay(const boost::filesystem::path& dir) {
+	printf("Journal replay\n");
+
+	const string mapName = (dir / "journaled.map").string();
+	const string referenceName = (dir / "reference.map").string();
+
+	writeTestMap(mapName);
+	writeTestMap(referenceName);
+
+	// A new map is loaded for every session
+	{
+		TemplateJournal journal (mapName, 3);
+
+		for (int session = 0; session < 10; session++) {
+			ObjectActionMap live, reference;
+			TemplateUpdateBuffer updates;
+
+			journal.load(live);
+			reference.readMap(referenceName);
+			CHECK(mapDifference(live, reference) < 1e-12);
+			CHECK(journal.getNumSessions() == static_cast<size_t>(session % 3));
+
+			addSessionUpdates(updates);
+			TemplateUpdateBuffer referenceUpdates (updates);
+
+			journal.append(updates);
+			updates.apply(live);
+			if (journal.needsCompaction()) {
+				journal.compact(live);
+			}
+
+			referenceUpdates.apply(reference);
+			reference.writeMap(referenceName);
+		}
+
+		journal.wait();
+
+		ObjectActionMap live, reference;
+		journal.load(live);
+		reference.readMap(referenceName);
+		CHECK(mapDifference(live, reference) < 1e-12);
+	}
+
+	// One map is kept in memory across the sessions, as by a recognizer that is reinitialized
+	{
+		TemplateJournal journal (mapName, 4);
+		ObjectActionMap live;
+
+		journal.load(live);
+
+		for (int session = 0; session < 10; session++) {
+			TemplateUpdateBuffer updates;
+
+			addSessionUpdates(updates);
+			journal.append(updates);
+			updates.apply(live);
+			if (journal.needsCompaction()) {
+				journal.compact(live);
+			}
+
+			ObjectActionMap replayed;
+			journal.wait();
+			journal.load(replayed);
+			CHECK(mapDifference(live, replayed) < 1e-12);
+		}
+	}
+}
+
+
+/// Creates the empty file \c fileName
+void touch(const string& fileName) {
+	ofstream file (fileName.c_str());
+}
+
+
+/**
+ * A compaction interrupted at any point is completed on the next load without losing
+ * or repeating the sessions it was folding into the map
+ */
+void testJournalCompactionRecovery(const boost::filesystem::path& dir) {
+	printf("Journal compaction recovery\n");
+
+	const string mapName = (dir / "recovered.map").string();
+	const string journalName = mapName + ".journal";
+	const string compactingName = mapName + ".journal.compacting";
+	const string compactedName = mapName + ".journal.compacted";
+	const string tempName = mapName + ".tmp";
+
+	// Stopped before the new map was complete, after the new map was written, after the rename
+	for (int stage = 0; stage < 3; stage++) {
+		ObjectActionMap before, after;
+
+		boost::filesystem::remove(journalName);
+		boost::filesystem::remove(compactingName);
+		boost::filesystem::remove(compactedName);
+		writeTestMap(mapName);
+
+		{
+			TemplateJournal journal (mapName, 0);
+
+			journal.load(after);
+			for (int session = 0; session < 2; session++) {
+				TemplateUpdateBuffer updates;
+
+				addSessionUpdates(updates);
+				journal.append(updates);
+				updates.apply(after);
+			}
+		}
+
+		// The state the compaction left behind
+		boost::filesystem::rename(journalName, compactingName);
+
+		if (stage == 0) {
+			touch(tempName);
+		} else {
+			after.writeMap(stage == 1 ? tempName : mapName);
+			touch(compactedName);
+		}
+
+		TemplateJournal journal (mapName, 0);
+		ObjectActionMap loaded, reloaded;
+
+		journal.load(loaded);
+		CHECK(mapDifference(loaded, after) < 1e-12);
+		CHECK(!boost::filesystem::exists(compactingName));
+		CHECK(!boost::filesystem::exists(compactedName));
+		CHECK(!boost::filesystem::exists(tempName));
+
+		journal.load(reloaded);
+		CHECK(mapDifference(reloaded, after) < 1e-12);
+	}
+}
+
+
+int main(int argc, char *argv[]) {
+	srand(1);
+
+	// Files written by the tests
+	const boost::filesystem::path dir = boost::filesystem::temp_directory_path()
+		/ boost::filesystem::unique_path("oar-tests-%%%%-%%%%");
+	boost::filesystem::create_directories(dir);
+
+	testQueryHeap();
+	testQueryStream();
+	testInteractionAnalysis();
+	testPlannerCache();
+	testAutoCommitPolicy(dir);
+	testPlannerDeadline();
+	testSceneCostModel();
+	testQueryTypeBandit(dir);
+	testCountMapTotals();
+	testIntentionHistoryWrapAround();
+	testNegativeUpdates(dir);
+	testBinaryMapRoundTrip(dir);
+	testJournalReplay(dir);
+	testJournalCompactionRecovery(dir);
+
+	boost::system::error_code ec;
+	boost::filesystem::remove_all(dir, ec);
+
+	printf("%s: %d failed checks\n", (numFailures == 0) ? "PASSED" : "FAILED", numFailures);
+	return (numFailures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+#endif
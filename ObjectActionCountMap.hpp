@@ -38,6 +38,8 @@
 #define OBJECT_ACTION_COUNT_MAP_H_
 
 #include <cstdlib>
+#include <vector>
+#include <algorithm>
 
 /**
  * \brief Namespace that encapsulates all of the functions and types relevant for human intention recognition
@@ -46,79 +48,163 @@ namespace oar {
 
 /**
  * \brief Map for storing object and action counts for a scene
+ *
+ * The row sums, column sums and grand total are kept up to date as pairs are counted,
+ * so every count and probability is available in constant time. The map grows when a
+ * pair beyond its current dimensions is counted.
  */
 class ObjectActionCountMap {
 private:
-	/// Number of possible objects
+	/// Default number of object categories
 	static const unsigned int NUM_OBJECTS = 11;
 
-	/// Number of possible actions
+	/// Default number of actions
 	static const unsigned int NUM_ACTIONS = 7;
 
-	/// Count map
-	size_t map[NUM_OBJECTS][NUM_ACTIONS];
+	/// Number of object categories (rows)
+	size_t numObjects;
+
+	/// Number of actions (columns)
+	size_t numActions;
+
+	/// Count map, stored row by row
+	std::vector<size_t> map;
+
+	/// Number of pairs counted for each object
+	std::vector<size_t> objectCounts;
+
+	/// Number of pairs counted for each action
+	std::vector<size_t> actionCounts;
+
+	/// Number of pairs counted
+	size_t totalCount;
 		
 
 public:
 	/// Default Constructor
-	ObjectActionCountMap() {
-		for (size_t i = 0; i < NUM_OBJECTS; i++) {
-			for (size_t j = 0; j < NUM_ACTIONS; j++) {
-				map[i][j] = 0;
-			}			
-		}
+	ObjectActionCountMap(const size_t& numObjs = NUM_OBJECTS, const size_t& numActs = NUM_ACTIONS) :
+		numObjects(0), numActions(0), totalCount(0) {
+		resize(numObjs, numActs);
 	}
 
 	~ObjectActionCountMap() {}
 
-	/// Get the number of objects associated with the action at \c actionIdx
-	size_t getActionCount(const size_t& actionIdx) {
-		size_t sum = 0;
-		for (size_t i = 0; i < NUM_OBJECTS; i++) {
-			sum += map[i][actionIdx];
+	/// Get the number of object categories
+	size_t getNumOfObjects() const {
+		return numObjects;
+	}
+
+	/// Get the number of actions
+	size_t getNumOfActions() const {
+		return numActions;
+	}
+
+	/**
+	 * \brief Resizes the map to \c numObjs object categories and \c numActs actions,
+	 * keeping the counts of the pairs that are still in range
+	 */
+	void resize(const size_t& numObjs, const size_t& numActs) {
+		std::vector<size_t> resized (numObjs * numActs, 0);
+
+		objectCounts.assign(numObjs, 0);
+		actionCounts.assign(numActs, 0);
+		totalCount = 0;
+
+		for (size_t i = 0; i < numObjs && i < numObjects; i++) {
+			for (size_t j = 0; j < numActs && j < numActions; j++) {
+				const size_t count = map[i * numActions + j];
+
+				resized[i * numActs + j] = count;
+				objectCounts[i] += count;
+				actionCounts[j] += count;
+				totalCount += count;
+			}
 		}
-		return sum;
+
+		map.swap(resized);
+		numObjects = numObjs;
+		numActions = numActs;
+	}
+
+	/// Reset all counts to zero
+	void clear() {
+		map.assign(map.size(), 0);
+		objectCounts.assign(numObjects, 0);
+		actionCounts.assign(numActions, 0);
+		totalCount = 0;
 	}
 
-	/// Get the number of actions associated with the object at 
-	size_t getObjectCount(const size_t& objectIdx) {
-		size_t sum = 0;
-		for (size_t i = 0; i < NUM_ACTIONS; i++) {
-			sum += map[objectIdx][i];
+	/// Get the number of times the pair \c objectIdx, \c actionIdx was counted
+	size_t getPairCount(const size_t& objectIdx, const size_t& actionIdx) const {
+		if (objectIdx >= numObjects || actionIdx >= numActions) {
+			return 0;
 		}
-		return sum;
+		return map[objectIdx * numActions + actionIdx];
+	}
+
+	/// Get the number of objects associated with the action at \c actionIdx
+	size_t getActionCount(const size_t& actionIdx) const {
+		return (actionIdx < numActions) ? actionCounts[actionIdx] : 0;
+	}
+
+	/// Get the number of actions associated with the object at \c objectIdx
+	size_t getObjectCount(const size_t& objectIdx) const {
+		return (objectIdx < numObjects) ? objectCounts[objectIdx] : 0;
 	}
 
 	/// Get the total number of objects and action relationships
-	size_t getTotalCount() {
-		size_t sum = 0;
-		for (size_t i = 0; i < NUM_OBJECTS; i++) {
-			for (size_t j = 0; j < NUM_ACTIONS; j++) {
-				sum += map[i][j];
-			}			
-		}
-		return sum;
+	size_t getTotalCount() const {
+		return totalCount;
 	}
 
 	/// Get the probability of the object at \c objectIdx
-	double getObjectProbability(const size_t& objectIdx) {
-		double objectCount = static_cast<double>(getObjectCount(objectIdx));
-		double totalCount = static_cast<double>(getTotalCount());
-
-		return (objectCount / totalCount);
+	double getObjectProbability(const size_t& objectIdx) const {
+		if (totalCount == 0) {
+			return 0.;
+		}
+		return (static_cast<double>(getObjectCount(objectIdx)) / totalCount);
 	}
 
 	/// Get the probability of the action at \c actionIdx
-	double getActionProbability(const size_t& actionIdx) {
-		double actionCount = static_cast<double>(getActionCount(actionIdx));
-		double totalCount = static_cast<double>(getTotalCount());
+	double getActionProbability(const size_t& actionIdx) const {
+		if (totalCount == 0) {
+			return 0.;
+		}
+		return (static_cast<double>(getActionCount(actionIdx)) / totalCount);
+	}
 
-		return (actionCount / totalCount);
+	/**
+	 * \brief Get the probabilities of all the objects and actions of a scene at once
+	 * \param objectIdxs The object category of each object of the scene
+	 * \param actionIdxs The action index of each action of the scene
+	 * \param objectProbs Receives the probability of each object in \c objectIdxs
+	 * \param actionProbs Receives the probability of each action in \c actionIdxs
+	 */
+	void getProbabilities(const std::vector<size_t>& objectIdxs, const std::vector<size_t>& actionIdxs,
+						  std::vector<double>& objectProbs, std::vector<double>& actionProbs) const {
+		const double scale = (totalCount == 0) ? 0. : 1. / totalCount;
+
+		objectProbs.resize(objectIdxs.size());
+		actionProbs.resize(actionIdxs.size());
+
+		for (size_t i = 0; i < objectIdxs.size(); i++) {
+			objectProbs[i] = scale * getObjectCount(objectIdxs[i]);
+		}
+		for (size_t j = 0; j < actionIdxs.size(); j++) {
+			actionProbs[j] = scale * getActionCount(actionIdxs[j]);
+		}
 	}
 
 	/// Update the map to indicate the presence of a particular object-action pair
 	void operator() (const size_t& objectIdx, const size_t& actionIdx) {
-		map[objectIdx][actionIdx] += 1;
+		if (objectIdx >= numObjects || actionIdx >= numActions) {
+			resize(std::max(numObjects, objectIdx + 1), std::max(numActions, actionIdx + 1));
+		}
+
+		map[objectIdx * numActions + actionIdx] += 1;
+		objectCounts[objectIdx] += 1;
+		actionCounts[actionIdx] += 1;
+		totalCount += 1;
 	}
 	
 
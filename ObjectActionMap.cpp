@@ -1,63 +1,199 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <boost/cstdint.hpp>
 #include "ObjectActionMap.h"
 
 
 namespace oar {
 
 
+namespace {
+
+/// Identifies a binary map file; text maps always start with an object index
+const char BINARY_MAGIC[8] = { 'O', 'A', 'R', 'M', 'A', 'P', '\0', '\x1a' };
+
+/// Version of the binary map layout
+const boost::uint32_t BINARY_VERSION = 1;
+
+/// Space reserved for an object or action name in a binary record, including the terminator
+const size_t BINARY_NAME_LENGTH = 24;
+
+
+/// Start of a binary map file
+struct BinaryMapHeader {
+	char magic[8];
+	boost::uint32_t version;
+	boost::uint32_t numObjects;
+	boost::uint32_t numActions;
+
+	/// FNV-1a hash of the records that follow
+	boost::uint32_t checksum;
+};
+
+
+/**
+ * A <object, action> pair of a binary map. There is one record for every pair, stored
+ * row by row, so the file can be indexed in place; the names of unused pairs are empty.
+ */
+struct BinaryMapRecord {
+	double factor[4];
+	boost::uint32_t objectIdx;
+	boost::uint32_t actionIdx;
+	char objectName[BINARY_NAME_LENGTH];
+	char actionName[BINARY_NAME_LENGTH];
+};
+
+
+/// FNV-1a hash of \c length bytes at \c data
+boost::uint32_t checksum(const void* data, const size_t& length) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	boost::uint32_t hash = 2166136261u;
+
+	for (size_t i = 0; i < length; i++) {
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+} // anonymous
+
+
+ObjectActionMap::MapFormat ObjectActionMap::detectFormat(const std::string& fileName) {
+	std::ifstream inFile (fileName.c_str(), std::ios::in | std::ios::binary);
+	char magic[sizeof(BINARY_MAGIC)];
+
+	if (inFile.read(magic, sizeof(magic)) && std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0) {
+		return BINARY_MAP;
+	}
+
+	return TEXT_MAP;
+}
+
+
 void ObjectActionMap::readMap(const std::string& fileName /* = "ObjectActionMap.map" */) {
+	MapFormat format = detectFormat(fileName);
+	bool loaded = (format == BINARY_MAP) ? readBinaryMap(fileName) : readTextMap(fileName);
+
+	if (loaded) {
+		fileFormat = format;
+	}
+}
+
+
+bool ObjectActionMap::readTextMap(const std::string& fileName) {
 	std::ifstream inFile;
 	inFile.open(fileName.c_str(), std::ios::in);
 
-	if (inFile.is_open()) {
-		while (!inFile.eof()) {
-			size_t actionIdx, objIndex;
-			std::string actionName, objName;
-			dai::Prob f(4);
-			double values[4];
-			double sum = 0.;
-
-			inFile >> objIndex;
-			inFile >> objName;
-			inFile >> actionIdx;
-			inFile >> actionName;
-
-			inFile >> values[0];
-			inFile >> values[1];
-			inFile >> values[2];
-			inFile >> values[3];
-			
-			sum = values[0] + values[1] + values[2] + values[3];
-			//sum = 1.;
-
-			f.set(0, values[0] / sum);
-			f.set(1, values[1] / sum);
-			f.set(2, values[2] / sum);
-			f.set(3, values[3] / sum);
-
-			ObjectActionProperty prop;
-			prop.objectIdx = objIndex;
-			prop.objectName = objName;
-			prop.actionIdx = actionIdx;
-			prop.actionName = actionName;
-			prop.factor = f;
-
-			if (!objName.empty() && !actionName.empty()) {
-				map[objIndex][actionIdx] = prop;
-			}
+	if (!inFile.is_open()) {
+		std::cerr << "ObjectActionMap: Unable to open file " << fileName << " for reading!\n";
+		return false;
+	}
+
+	size_t actionIdx, objIndex;
+	std::string actionName, objName;
+	double values[4];
+
+	// Stops at the first line that cannot be read completely, e.g. after the last one
+	while (inFile >> objIndex >> objName >> actionIdx >> actionName >> values[0] >> values[1] >> values[2] >> values[3]) {
+		dai::Prob f(4);
+		double sum = values[0] + values[1] + values[2] + values[3];
+		//sum = 1.;
+
+		if (objIndex >= NUM_OBJECTS || actionIdx >= NUM_ACTIONS) {
+			std::cerr << "ObjectActionMap: Skipping pair with invalid indices in " << fileName << "\n";
+			continue;
 		}
 
-		inFile.close();		
+		f.set(0, values[0] / sum);
+		f.set(1, values[1] / sum);
+		f.set(2, values[2] / sum);
+		f.set(3, values[3] / sum);
 
-	} else {
+		ObjectActionProperty prop;
+		prop.objectIdx = objIndex;
+		prop.objectName = objName;
+		prop.actionIdx = actionIdx;
+		prop.actionName = actionName;
+		prop.factor = f;
+
+		map[objIndex][actionIdx] = prop;
+	}
+
+	inFile.close();
+	return true;
+}
+
+
+bool ObjectActionMap::readBinaryMap(const std::string& fileName) {
+	std::ifstream inFile (fileName.c_str(), std::ios::in | std::ios::binary);
+	BinaryMapHeader header;
+	std::vector<BinaryMapRecord> records (NUM_OBJECTS * NUM_ACTIONS);
+
+	if (!inFile.is_open()) {
 		std::cerr << "ObjectActionMap: Unable to open file " << fileName << " for reading!\n";
+		return false;
+	}
+
+	if (!inFile.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.version != BINARY_VERSION
+		|| header.numObjects != NUM_OBJECTS || header.numActions != NUM_ACTIONS) {
+		std::cerr << "ObjectActionMap: " << fileName << " is not a version " << BINARY_VERSION << " map of "
+			<< NUM_OBJECTS << " objects and " << NUM_ACTIONS << " actions!\n";
+		return false;
+	}
+
+	// The records are read in one block and only used once their checksum matches
+	const size_t recordBytes = records.size() * sizeof(BinaryMapRecord);
+
+	if (!inFile.read(reinterpret_cast<char*>(&records[0]), recordBytes) || checksum(&records[0], recordBytes) != header.checksum) {
+		std::cerr << "ObjectActionMap: " << fileName << " is truncated or corrupt!\n";
+		return false;
+	}
+
+	for (size_t i = 0; i < records.size(); i++) {
+		const BinaryMapRecord& record = records[i];
+
+		if (record.objectName[0] == '\0' || record.actionName[0] == '\0') {
+			continue;
+		}
+
+		ObjectActionProperty prop;
+		prop.objectIdx = record.objectIdx;
+		prop.objectName = std::string(record.objectName, std::find(record.objectName, record.objectName + BINARY_NAME_LENGTH, '\0'));
+		prop.actionIdx = record.actionIdx;
+		prop.actionName = std::string(record.actionName, std::find(record.actionName, record.actionName + BINARY_NAME_LENGTH, '\0'));
+
+		for (size_t k = 0; k < 4; k++) {
+			prop.factor.set(k, record.factor[k]);
+		}
+
+		map[i / NUM_ACTIONS][i % NUM_ACTIONS] = prop;
 	}
+
+	return true;
 }
 
 
-void ObjectActionMap::writeMap(const std::string& fileName /* = "ObjectActionMap.xml" */) {
+bool ObjectActionMap::writeMap(const std::string& fileName /* = "ObjectActionMap.map" */) {
+	return writeMap(fileName, fileFormat);
+}
+
+
+bool ObjectActionMap::writeMap(const std::string& fileName, const MapFormat& format) {
+	if (format == BINARY_MAP) {
+		return writeBinaryMap(fileName);
+	} else {
+		return writeTextMap(fileName);
+	}
+}
+
+
+bool ObjectActionMap::writeTextMap(const std::string& fileName) {
 	std::ofstream outFile;
 	outFile.open(fileName.c_str(), std::ios::out);
 
@@ -94,10 +230,68 @@ void ObjectActionMap::writeMap(const std::string& fileName /* = "ObjectActionMap
 		}
 
 		outFile.close();
+		return !outFile.fail();
 
 	} else {
 		std::cerr << "ObjectActionMap: Unable to open file " << fileName << " for writing!\n";
+		return false;
+	}
+}
+
+
+bool ObjectActionMap::writeBinaryMap(const std::string& fileName) {
+	std::vector<BinaryMapRecord> records (NUM_OBJECTS * NUM_ACTIONS);
+	BinaryMapHeader header;
+
+	// Zero everything, padding included, so that identical maps give identical files
+	std::memset(&records[0], 0, records.size() * sizeof(BinaryMapRecord));
+	std::memset(&header, 0, sizeof(header));
+
+	for (size_t i = 0; i < this->NUM_OBJECTS; i++) {
+		for (size_t j = 0; j < this->NUM_ACTIONS; j++) {
+			const ObjectActionProperty& prop = map[i][j];
+			BinaryMapRecord& record = records[i * NUM_ACTIONS + j];
+
+			if (prop.objectName.empty() || prop.actionName.empty()) {
+				continue;
+			}
+
+			double factorSum = 0.;
+
+			for (size_t k = 0; k < 4; ++k) {
+				factorSum += prop.factor.get(k);
+			}
+
+			// Stored normalized, as in text maps, but without rounding
+			for (size_t k = 0; k < 4; ++k) {
+				record.factor[k] = prop.factor.get(k) / factorSum;
+			}
+
+			record.objectIdx = static_cast<boost::uint32_t>(prop.objectIdx);
+			record.actionIdx = static_cast<boost::uint32_t>(prop.actionIdx);
+			prop.objectName.copy(record.objectName, BINARY_NAME_LENGTH - 1);
+			prop.actionName.copy(record.actionName, BINARY_NAME_LENGTH - 1);
+		}
+	}
+
+	std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+	header.version = BINARY_VERSION;
+	header.numObjects = NUM_OBJECTS;
+	header.numActions = NUM_ACTIONS;
+	header.checksum = checksum(&records[0], records.size() * sizeof(BinaryMapRecord));
+
+	std::ofstream outFile (fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+	if (!outFile.is_open()) {
+		std::cerr << "ObjectActionMap: Unable to open file " << fileName << " for writing!\n";
+		return false;
 	}
+
+	outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	outFile.write(reinterpret_cast<const char*>(&records[0]), records.size() * sizeof(BinaryMapRecord));
+	outFile.close();
+
+	return !outFile.fail();
 }
 
 
@@ -117,9 +311,21 @@ void ObjectActionMap::resetToDefault() {
 
 
 void ObjectActionMap::updateMap(const size_t& oIdx, const size_t& aIdx) {
+	updateMap(oIdx, aIdx, lambda);
+}
+
+
+void ObjectActionMap::updateMap(const size_t& oIdx, const size_t& aIdx, const double& delta) {
 	if (aIdx >= 0 && aIdx < this->NUM_ACTIONS && oIdx >= 0 && oIdx < this->NUM_OBJECTS) {
-		double value = map[oIdx][aIdx].factor.get(3);
-		map[oIdx][aIdx].factor.set(3, value + lambda);
+		dai::Prob& factor = map[oIdx][aIdx].factor;
+		double value = factor.get(3);
+
+		/*
+		 * Negative feedback can make a pair as incompatible as the states in which the
+		 * object or the action is absent, but no less, so the potential never vanishes
+		 */
+		double floor = std::min(factor.get(0), std::min(factor.get(1), factor.get(2)));
+		factor.set(3, std::max(value + delta, std::min(value, floor)));
 		
 	} else {
 		std::cerr << "ObjectActionMap: Invalid indices provided for map update\n";
@@ -127,6 +333,24 @@ void ObjectActionMap::updateMap(const size_t& oIdx, const size_t& aIdx) {
 }
 
 
+void ObjectActionMap::normalizeTemplate(const size_t& oIdx, const size_t& aIdx) {
+	if (aIdx < this->NUM_ACTIONS && oIdx < this->NUM_OBJECTS) {
+		dai::Prob& factor = map[oIdx][aIdx].factor;
+		double factorSum = 0.;
+
+		for (size_t k = 0; k < 4; ++k) {
+			factorSum += factor.get(k);
+		}
+
+		if (factorSum > 0.) {
+			for (size_t k = 0; k < 4; ++k) {
+				factor.set(k, factor.get(k) / factorSum);
+			}
+		}
+	}
+}
+
+
 double ObjectActionMap::getLambda() const {
 	return lambda;
 }
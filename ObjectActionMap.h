@@ -39,6 +39,7 @@
 
 
 #include <cstdlib>
+#include <string>
 #include <dai/prob.h>
 
 
@@ -104,6 +105,15 @@ struct ObjectActionProperty {
  * \brief Template map of all possible object and action relationships and their properties
  */
 class ObjectActionMap {
+public:
+	/// Formats in which a map can be stored
+	enum MapFormat {
+		TEXT_MAP,		///< One whitespace-separated line per <object, action> pair, for inspection and editing
+		BINARY_MAP		///< Versioned and checksummed fixed-size records, loaded without parsing. The records are
+						///< written as laid out in memory, i.e. host-endian with the padding of the compiler, so
+						///< binary maps can only be shared between builds of the same ABI
+	};
+
 private:
 	/// Number of possible objects
 	static const unsigned int NUM_OBJECTS = 11;
@@ -116,29 +126,64 @@ private:
 
 	/// Template factor map that is updated based on observations
 	ObjectActionProperty map [NUM_OBJECTS][NUM_ACTIONS];
+
+	/// Format of the file the map was last read from, in which it is written by default
+	MapFormat fileFormat;
+
+	/// Reads a text map, replacing the pairs it lists
+	bool readTextMap (const std::string& fileName);
+
+	/// Reads a binary map, leaving the map as it is if the file is not valid
+	bool readBinaryMap (const std::string& fileName);
+
+	/// Writes the map as text
+	bool writeTextMap (const std::string& fileName);
+
+	/// Writes the map in the binary format
+	bool writeBinaryMap (const std::string& fileName);
 		
 
 public:
 	/// Default constructor
-	ObjectActionMap () : lambda(1.0) {}
+	ObjectActionMap () : lambda(1.0), fileFormat(TEXT_MAP) {}
 	
 	/// Access the template object-action property at the location specified 
 	ObjectActionProperty operator() (const size_t& oIdx, const size_t& aIdx) {
 		return map[oIdx][aIdx];
 	}
 	
-	/// Reads an object-action map from file
+	/// Reads an object-action map from file, in either format
 	void readMap (const std::string& fileName = "ObjectActionMap.map");
 
-	/// Writes an object-action map to file
-	void writeMap (const std::string& fileName = "ObjectActionMap.map");
+	/// Writes an object-action map to file, in the format it was read in; false if it could not be written
+	bool writeMap (const std::string& fileName = "ObjectActionMap.map");
+
+	/// Writes an object-action map to file in the format \c format; false if it could not be written
+	bool writeMap (const std::string& fileName, const MapFormat& format);
+
+	/// Determines the format of the map file \c fileName; files that are not binary maps are taken to be text
+	static MapFormat detectFormat (const std::string& fileName);
+
+	/// Gets the format the map is written in by default
+	MapFormat getFormat() const {
+		return fileFormat;
+	}
 
 	/// Updates the object-action map template factors according to observations
 	void updateMap (const size_t& oIdx, const size_t& aIdx);
 
+	/**
+	 * \brief Adds \c delta to the compatibility of the <object, action> template. A negative
+	 * \c delta never lowers it below the compatibilities of the other states.
+	 */
+	void updateMap (const size_t& oIdx, const size_t& aIdx, const double& delta);
+
 	/// Reset map to default probabilities
 	void resetToDefault();
 
+	/// Scales the compatibilities of the <object, action> template to sum to 1, as they are when read from file
+	void normalizeTemplate (const size_t& oIdx, const size_t& aIdx);
+
 	/// Get the learning rate 
 	double getLambda() const;
 
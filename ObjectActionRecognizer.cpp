@@ -1,6 +1,7 @@
 #include <iostream>
 #include <fstream>
 #include <cassert>
+#include <algorithm>
 #include <ctime>
 #include <exception>
 #include <boost/foreach.hpp>
@@ -14,8 +15,14 @@ using namespace dai;
 namespace oar {
 
 
-ObjectActionRecognizer::ObjectActionRecognizer(const std::string& oaMapName, const double& learningRate) {
-	srand(static_cast<unsigned int>(time(NULL)));
+const int ObjectActionRecognizer::NO_CHOICE;
+
+
+ObjectActionRecognizer::ObjectActionRecognizer(const std::string& oaMapName, const double& learningRate) : 
+	tieBreaks(static_cast<unsigned int>(time(NULL))), planner(NULL), lookahead(NULL), policy(), autoCommit(NULL), sessionConfidence(-1.), committed(false),
+	typeBandit(NULL), banditContext(0), mapPreloaded(false), latencyBudget(0.), scoringTier(FULL_INFERENCE),
+	negativeLearningRate(0.), history(NULL), journal(NULL),
+	banditWeighted(false), banditInteractions(0), templateQuerySet(false), costModel(NULL) {
 
 	if (!oaMapName.empty()) {
 		this->objectActionMapFileName = oaMapName;
@@ -25,12 +32,43 @@ ObjectActionRecognizer::ObjectActionRecognizer(const std::string& oaMapName, con
 	}
 
 	objectActionMap.setLambda(learningRate);
-	inferenceAlgo = NULL;
 	applyTemplates();	
 
 }
 
 
+ObjectActionRecognizer::ObjectActionRecognizer(const ObjectActionMap& oaMap, const double& learningRate) : 
+	tieBreaks(static_cast<unsigned int>(time(NULL))), planner(NULL), lookahead(NULL), policy(), autoCommit(NULL), sessionConfidence(-1.), committed(false),
+	typeBandit(NULL), banditContext(0), mapPreloaded(true), latencyBudget(0.), scoringTier(FULL_INFERENCE),
+	negativeLearningRate(0.), history(NULL), journal(NULL),
+	banditWeighted(false), banditInteractions(0), templateQuerySet(false), costModel(NULL) {
+
+	objectActionMap = oaMap;
+	objectActionMap.setLambda(learningRate);
+	applyTemplates();
+
+}
+
+
+ObjectActionRecognizer::ObjectActionRecognizer(TemplateJournal* journal, const double& learningRate) : 
+	tieBreaks(static_cast<unsigned int>(time(NULL))), planner(NULL), lookahead(NULL), policy(), autoCommit(NULL), sessionConfidence(-1.), committed(false),
+	typeBandit(NULL), banditContext(0), mapPreloaded(false), latencyBudget(0.), scoringTier(FULL_INFERENCE),
+	negativeLearningRate(0.), history(NULL), journal(journal),
+	banditWeighted(false), banditInteractions(0), templateQuerySet(false), costModel(NULL) {
+
+	if (journal == NULL) {
+		fprintf(stderr, "ObjectActionRecognizer Error: Template journal provided is invalid!\n");
+		return;
+	}
+
+	this->objectActionMapFileName = journal->getMapFileName();
+	objectActionMap.setLambda(learningRate);
+	applyTemplates();
+	journal->load(objectActionMap);
+
+}
+
+
 ObjectActionRecognizer::~ObjectActionRecognizer() {
 	clean();
 }
@@ -44,124 +82,153 @@ void ObjectActionRecognizer::clean() {
 	allFactors.clear();
 	objectCategoryInstances.clear();
 	objectActionFactors.clear();
+	factorEndpoints.clear();
+	affordances.clear();
 	actionTemplateIndex.clear();	
+	queryNames.clear();
+	nodeNameIds.clear();
+	speculation.cancel();
+	state.clear();
+	plannedQueries.clear();
+	policy.reset();
 	factorCount = 0;
 	nodeCount = 0;
 	lastFactorIndex = 0;
-
-	if (inferenceAlgo) {
-		delete inferenceAlgo;
-	}	
+	scene.reset();
 }
 
 
 void ObjectActionRecognizer::reinitialize() {
+	endSession();
 	clean();
 
-	if (this->objectActionMapFileName.empty()) {
+	if (this->objectActionMapFileName.empty() && !mapPreloaded) {
 		fprintf(stderr, "ObjectActionRecognizer Error: Map filename is invalid!\n");
 		return;
 	}
 
-	inferenceAlgo = NULL;
-
 	if (templateCompats.empty() && objectCategoryInstances.empty()) {
 		applyTemplates();
 	}
 }
 
 
+void ObjectActionRecognizer::setSeed(const unsigned int& seed) {
+	tieBreaks.reseed(seed);
+}
+
+
+unsigned int ObjectActionRecognizer::getSeed() const {
+	return tieBreaks.seed();
+}
+
+
+const char* ObjectActionRecognizer::getScoringTierName(const ScoringTier& tier) {
+	switch (tier) {
+		case FULL_INFERENCE:
+			return "full inference";
+		case ANYTIME_INFERENCE:
+			return "anytime inference";
+		case COUNT_SCORES:
+			return "scene counts";
+		case PRIOR_SCORES:
+			return "template priors";
+	}
+	return "unknown";
+}
+
+
 void ObjectActionRecognizer::applyTemplates() {
 	// Bottles
 	ObjectTemplateProperties bottleProps;
 	bottleProps.index = 0;
 	bottleProps.name = "Bottle";
-	bottleProps.actions.push_back(DRINK);
-	bottleProps.actions.push_back(GRASP);
-	bottleProps.actions.push_back(MOVE);
-	bottleProps.actions.push_back(OPEN);
-	bottleProps.actions.push_back(POUR);
+	bottleProps.addAction(DRINK);
+	bottleProps.addAction(GRASP);
+	bottleProps.addAction(MOVE);
+	bottleProps.addAction(OPEN);
+	bottleProps.addAction(POUR);
 	
 	// Bowls
 	ObjectTemplateProperties bowlProps;
 	bowlProps.index = 1;
 	bowlProps.name = "Bowl";
-	bowlProps.actions.push_back(GRASP);
-	bowlProps.actions.push_back(MOVE);
-	bowlProps.actions.push_back(PUSH);
+	bowlProps.addAction(GRASP);
+	bowlProps.addAction(MOVE);
+	bowlProps.addAction(PUSH);
 	
 	// Boxes
 	ObjectTemplateProperties boxProps;
 	boxProps.index = 2;
 	boxProps.name = "Box";
-	boxProps.actions.push_back(GRASP);
-	boxProps.actions.push_back(MOVE);
-	boxProps.actions.push_back(OPEN);
-	boxProps.actions.push_back(PUSH);
+	boxProps.addAction(GRASP);
+	boxProps.addAction(MOVE);
+	boxProps.addAction(OPEN);
+	boxProps.addAction(PUSH);
 	
 	// Cans
 	ObjectTemplateProperties canProps;
 	canProps.index = 3;
 	canProps.name = "Can";
-	canProps.actions.push_back(DRINK);
-	canProps.actions.push_back(GRASP);
-	canProps.actions.push_back(MOVE);
-	canProps.actions.push_back(POUR);
+	canProps.addAction(DRINK);
+	canProps.addAction(GRASP);
+	canProps.addAction(MOVE);
+	canProps.addAction(POUR);
 	
 	// Cartons
 	ObjectTemplateProperties cartonProps;
 	cartonProps.index = 4;
 	cartonProps.name = "Carton";
-	cartonProps.actions.push_back(GRASP);
-	cartonProps.actions.push_back(MOVE);
-	cartonProps.actions.push_back(OPEN);
-	cartonProps.actions.push_back(POUR);
+	cartonProps.addAction(GRASP);
+	cartonProps.addAction(MOVE);
+	cartonProps.addAction(OPEN);
+	cartonProps.addAction(POUR);
 	
 	// Cups
 	ObjectTemplateProperties cupProps;
 	cupProps.index = 5;
 	cupProps.name = "Cup";
-	cupProps.actions.push_back(DRINK);
-	cupProps.actions.push_back(GRASP);
-	cupProps.actions.push_back(MOVE);
+	cupProps.addAction(DRINK);
+	cupProps.addAction(GRASP);
+	cupProps.addAction(MOVE);
 	
 	// Mugs
 	ObjectTemplateProperties mugProps;
 	mugProps.index = 6;
 	mugProps.name = "Mug";
-	mugProps.actions.push_back(DRINK);
-	mugProps.actions.push_back(GRASP);
-	mugProps.actions.push_back(MOVE);
+	mugProps.addAction(DRINK);
+	mugProps.addAction(GRASP);
+	mugProps.addAction(MOVE);
 	
 	// SprayCans
 	ObjectTemplateProperties sprayCanProps;
 	sprayCanProps.index = 7;
 	sprayCanProps.name = "SprayCan";
-	sprayCanProps.actions.push_back(GRASP);
+	sprayCanProps.addAction(GRASP);
 	
 	// Tins
 	ObjectTemplateProperties tinProps;
 	tinProps.index = 8;
 	tinProps.name = "Tin";
-	tinProps.actions.push_back(GRASP);
-	tinProps.actions.push_back(MOVE);
-	tinProps.actions.push_back(OPEN);
-	tinProps.actions.push_back(POUR);
+	tinProps.addAction(GRASP);
+	tinProps.addAction(MOVE);
+	tinProps.addAction(OPEN);
+	tinProps.addAction(POUR);
 	
 	// Tubes
 	ObjectTemplateProperties tubeProps;
 	tubeProps.index = 9;
 	tubeProps.name = "Tube";
-	tubeProps.actions.push_back(GRASP);
-	tubeProps.actions.push_back(SQUEEZE);
+	tubeProps.addAction(GRASP);
+	tubeProps.addAction(SQUEEZE);
 	
 	// Tubs
 	ObjectTemplateProperties tubContainerProps;
 	tubContainerProps.index = 10;
 	tubContainerProps.name = "Tub";
-	tubContainerProps.actions.push_back(GRASP);
-	tubContainerProps.actions.push_back(OPEN);
-	tubContainerProps.actions.push_back(PUSH);
+	tubContainerProps.addAction(GRASP);
+	tubContainerProps.addAction(OPEN);
+	tubContainerProps.addAction(PUSH);
 	
 
 	/*
@@ -184,7 +251,10 @@ void ObjectActionRecognizer::applyTemplates() {
 	 * Read object-action template map
 	 */
 	// TODO: If file is not available, use defaults
-	objectActionMap.readMap(objectActionMapFileName);
+	// With a journal, the map is loaded through it and holds the updates of the ended sessions
+	if (!mapPreloaded && journal == NULL) {
+		objectActionMap.readMap(objectActionMapFileName);
+	}
 		
 	for (size_t i = 0; i < NUM_OBJ_CATEGORIES; i++) {
 		std::vector<size_t> objCategory;
@@ -212,6 +282,7 @@ NetworkNode ObjectActionRecognizer::createGraphNode(const std::string& nodeName,
 			
 			nodeType = dai::OBJECT;
 			objectNames[nodeCount] = newObjectName;
+			setNodeNameId(nodeCount, queryNames.intern(newObjectName));
 			variableNode = NetworkNode(nodeCount, 2, newObjectName, type);				
 	
 			// Store the node information globally 
@@ -247,6 +318,7 @@ NetworkNode ObjectActionRecognizer::createGraphNode(const std::string& nodeName,
 				// Store the node information globally 
 				allNodes.push_back(NodeProperties(actionNodeIdx, nodeName, nodeType));
 				actionTemplateIndex[actionNodeIdx] = indexInTemplate;
+				setNodeNameId(actionNodeIdx, queryNames.intern(nodeName));
 				
 				nodeCount++;
 			}
@@ -280,6 +352,14 @@ NetworkNode ObjectActionRecognizer::createGraphNode(const std::string& nodeName,
 }
 
 
+void ObjectActionRecognizer::setNodeNameId(const size_t& label, const int& nameId) {
+	if (nodeNameIds.size() <= label) {
+		nodeNameIds.resize(label + 1, -1);
+	}
+	nodeNameIds[label] = nameId;
+}
+
+
 void ObjectActionRecognizer::addGraphFactor(FactorList& factorList, dai::Factor& newFactor) {
 	factorList.push_back(newFactor);
 	++factorCount;
@@ -302,54 +382,19 @@ FactorList ObjectActionRecognizer::instantiateObject(const std::string& objName,
 	}
 
 	// Get the category to which this scene object belongs
-	ObjectTemplateProperties objectCategory = templateCompats[categoryIndex];
+	const ObjectTemplateProperties& objectCategory = templateCompats[categoryIndex];
 	
 	/*
 	 * Create the action nodes for this object FIRST, so that their labels precede the object's
 	 * This is essence creates the first level of the graph, which is part of the ancillary
 	 * layer.
 	 */
-	for (size_t i = 0; i < objectCategory.actions.size(); i++) {
-		size_t templateActionIdx = 0;
-		std::string actionName;
-		
-		switch (objectCategory.actions[i]) {
-			case DRINK:
-				templateActionIdx = 0;
-				actionName = "Drink";
-				break;
-			case GRASP:
-				templateActionIdx = 1;
-				actionName = "Grasp";
-				break;
-			case MOVE:
-				templateActionIdx = 2;
-				actionName = "Move";
-				break;
-			case OPEN:
-				templateActionIdx = 3;
-				actionName = "Open";
-				break;
-			case POUR:
-				templateActionIdx = 4;
-				actionName = "Pour";
-				break;
-			case PUSH:
-				templateActionIdx = 5;
-				actionName = "Push";
-				break;
-			case SQUEEZE:
-				templateActionIdx = 6;
-				actionName = "Squeeze";
-				break;
-			default:
-				templateActionIdx = 1;
-				actionName = "Grasp";
-				break;
+	for (size_t templateActionIdx = 0; templateActionIdx < NUM_ACTIONS; templateActionIdx++) {
+		if (objectCategory.affords(templateActionIdx)) {
+			std::string actionName = ActionName()(static_cast<Action>(templateActionIdx));
+			NetworkNode actionNode = createGraphNode(actionName, dai::ACTION, templateActionIdx);
+			objectActionNodes.push_back(actionNode);
 		}
-		
-		NetworkNode actionNode = createGraphNode(actionName, dai::ACTION, templateActionIdx);
-		objectActionNodes.push_back(actionNode);
 	}
 	
 	/*
@@ -373,10 +418,13 @@ FactorList ObjectActionRecognizer::instantiateObject(const std::string& objName,
 		// Add to object-action pair count
 		objectActionCountMap(templateObjectIdx, templateActionIdx);
 		
+		// Weight the compatibility by how likely the pair is to follow the last intention
+		const double sequenceWeight = history ? history->weight(templateObjectIdx, templateActionIdx) : 1.;
+
 		objActionCompat.set(0, prop(0));
 		objActionCompat.set(1, prop(1));
 		objActionCompat.set(2, prop(2));
-		objActionCompat.set(3, prop(3));
+		objActionCompat.set(3, prop(3) * sequenceWeight);
 		
 		/// Adds an object-action compatibility to the list of factors for this object
 		addGraphFactor(objFactors, objActionCompat);	
@@ -384,11 +432,24 @@ FactorList ObjectActionRecognizer::instantiateObject(const std::string& objName,
 		// Add index of recently created <object, action> factor to the list of factors for this object instance
 		objectActionFactorIndices.push_back(lastFactorIndex);
 
+		// Record the nodes the factor connects, so that they never have to be looked up in the network
+		if (factorEndpoints.size() <= lastFactorIndex) {
+			factorEndpoints.resize(lastFactorIndex + 1);
+		}
+		factorEndpoints[lastFactorIndex] = FactorEndpoints(objectNode.label(), objectActionNodes[i].label());
+
 	}
 
 	// Store objectActionFactors for this particular object instance
 	objectActionFactors[objectNode.label()] = objectActionFactorIndices;
 
+	// Record the actions that the instance affords in the scene
+	std::vector<size_t> actionLabels (objectActionNodes.size());
+	for (size_t i = 0; i < objectActionNodes.size(); i++) {
+		actionLabels[i] = objectActionNodes[i].label();
+	}
+	affordances.addObject(objectNode.label(), actionLabels);
+
 	
 	// Create the object and position factors 
 	// FIXME: the probability formulation needs to be adjusted
@@ -414,8 +475,7 @@ FactorList ObjectActionRecognizer::instantiateObject(const std::string& objName,
 
 
 void ObjectActionRecognizer::getMarginalProbabilities() {
-	std::vector<NetworkNode> nodes = theNetwork.vars();
-	std::vector<dai::Factor> factors = theNetwork.factors();
+	const std::vector<NetworkNode>& nodes = scene->network().vars();
 
 	actions.clear();
 	objects.clear();
@@ -425,34 +485,23 @@ void ObjectActionRecognizer::getMarginalProbabilities() {
 		if (nodes[i].type() == dai::ACTION) {
 			NodeProbabilityPair s;
 			s.first = i;
-			s.second = inferenceAlgo->belief(nodes[i])[1];
+			s.second = scene->nodeProbability(i);
 			actions.push_back(s);				
 
 		} else if (nodes[i].type() == dai::OBJECT) {
 			NodeProbabilityPair s;
 			s.first = i;
-			s.second = inferenceAlgo->belief(nodes[i])[1];
+			s.second = scene->nodeProbability(i);
 			objects.push_back(s);
 
 		}
 	}	
 
-	for (size_t k = 0; k < factors.size(); k++) {
-		std::vector<NetworkNode> vars = factors[k].vars().elements();
-		bool relevant = false;
-
-		if (vars.size() == 2) {
-			if (vars[0].type() == dai::ACTION && vars[1].type() == dai::OBJECT) {
-				relevant = true;					
-			} else if (vars[1].type() == dai::ACTION && vars[0].type() == dai::OBJECT) {
-				relevant = true;	
-			}
-		}	
-
-		if (relevant == true) {
+	for (size_t k = 0; k < factorEndpoints.size(); k++) {
+		if (factorEndpoints[k].isRelation()) {
 			NodeProbabilityPair s;
 			s.first = k;
-			s.second = inferenceAlgo->belief(factors[k].vars())[3];
+			s.second = scene->relationProbability(k);
 			relations.push_back(s); 						
 		}			
 	}
@@ -461,8 +510,10 @@ void ObjectActionRecognizer::getMarginalProbabilities() {
 
 
 void ObjectActionRecognizer::getNumericalProbabilities() {
-	std::vector<NetworkNode> nodes = theNetwork.vars();
-	std::vector<dai::Factor> factors = theNetwork.factors();
+	const std::vector<NetworkNode>& nodes = scene->network().vars();
+
+	std::vector<size_t> objectIdxs, actionIdxs;
+	std::vector<double> objectProbs, actionProbs;
 
 	actions.clear();
 	objects.clear();
@@ -470,38 +521,34 @@ void ObjectActionRecognizer::getNumericalProbabilities() {
 
 	for (size_t i = 0; i < nodes.size(); i++) {
 		if (nodes[i].type() == dai::ACTION) {
-			NodeProbabilityPair s;
-			size_t actionIdx = actionTemplateIndex[nodes[i].label()];
-			s.first = i;
-			s.second = objectActionCountMap.getActionProbability(actionIdx);
-			actions.push_back(s);				
+			actions.push_back(NodeProbabilityPair(i, 0.));
+			actionIdxs.push_back(actionTemplateIndex[nodes[i].label()]);
 
 		} else if (nodes[i].type() == dai::OBJECT) {
-			NodeProbabilityPair s;
-			size_t objectIdx = objectTemplateIndex[nodes[i].label()];
-			s.first = i;
-			s.second = objectActionCountMap.getObjectProbability(objectIdx);
-			objects.push_back(s);
-
+			objects.push_back(NodeProbabilityPair(i, 0.));
+			objectIdxs.push_back(objectTemplateIndex[nodes[i].label()]);
 		}
 	}	
 
-	for (size_t k = 0; k < factors.size(); k++) {
-		std::vector<NetworkNode> vars = factors[k].vars().elements();
-		bool relevant = false;
+	// Look up the probabilities of the whole scene at once
+	objectActionCountMap.getProbabilities(objectIdxs, actionIdxs, objectProbs, actionProbs);
 
-		if (vars.size() == 2) {
-			if (vars[0].type() == dai::ACTION && vars[1].type() == dai::OBJECT) {
-				relevant = true;					
-			} else if (vars[1].type() == dai::ACTION && vars[0].type() == dai::OBJECT) {
-				relevant = true;	
-			}
-		}	
+	for (size_t j = 0; j < objects.size(); j++) {
+		objects[j].second = objectProbs[j];
+	}
+	for (size_t j = 0; j < actions.size(); j++) {
+		actions[j].second = actionProbs[j];
+	}
+
+	// A scene without any <object, action> pair has no relations to score
+	const size_t totalCount = objectActionCountMap.getTotalCount();
+	const double relationProb = (totalCount == 0) ? 0. : 1. / totalCount;
 
-		if (relevant == true) {
+	for (size_t k = 0; k < factorEndpoints.size(); k++) {
+		if (factorEndpoints[k].isRelation()) {
 			NodeProbabilityPair s;
 			s.first = k;
-			s.second = static_cast<double>(1. / objectActionCountMap.getTotalCount());
+			s.second = relationProb;
 			relations.push_back(s); 						
 		}			
 	}
@@ -509,9 +556,84 @@ void ObjectActionRecognizer::getNumericalProbabilities() {
 }
 
 
+void ObjectActionRecognizer::getPriorProbabilities() {
+	const dai::FactorGraph& net = scene->network();
+	const std::vector<NetworkNode>& nodes = net.vars();
+	std::vector<double> nodePriors(nodes.size(), 0.);
+	double totalPrior = 0.;
+	SceneCostModel& model = getCostModel();
+
+	actions.clear();
+	objects.clear();
+	relations.clear();
+
+	/*
+	 * The normalized compatibility of the joint state (1, 1) of each template is its
+	 * prior score. It only changes with the template map, so it is kept by the cost model
+	 * rather than computed for every scene.
+	 */
+	if (!model.hasTemplatePriors()) {
+		const size_t numObjs = objectActionMap.getNumOfObjects();
+		const size_t numActs = objectActionMap.getNumOfActions();
+		std::vector<double> templatePriors (numObjs * numActs, 0.);
+
+		for (size_t o = 0; o < numObjs; o++) {
+			for (size_t a = 0; a < numActs; a++) {
+				ObjectActionProperty prop = objectActionMap(o, a);
+				const double sum = prop(0) + prop(1) + prop(2) + prop(3);
+
+				templatePriors[o * numActs + a] = (sum > 0.) ? prop(3) / sum : 0.;
+			}
+		}
+
+		model.setTemplatePriors(templatePriors, numActs);
+	}
+
+	/*
+	 * The prior of the template of each <object, action> factor, weighted as the factor is
+	 * by the intention history, is taken as the unnormalized prior of its intention; nodes
+	 * get the prior mass of the intentions they take part in
+	 */
+	for (size_t k = 0; k < factorEndpoints.size(); k++) {
+		if (factorEndpoints[k].isRelation()) {
+			const size_t templateObjectIdx = objectTemplateIndex[factorEndpoints[k].objectLabel];
+			const size_t templateActionIdx = actionTemplateIndex[factorEndpoints[k].actionLabel];
+			const double sequenceWeight = history ? history->weight(templateObjectIdx, templateActionIdx) : 1.;
+			const double prior = model.getTemplatePrior(templateObjectIdx, templateActionIdx) * sequenceWeight;
+
+			relations.push_back(NodeProbabilityPair(k, prior));
+			nodePriors[factorEndpoints[k].objectLabel] += prior;
+			nodePriors[factorEndpoints[k].actionLabel] += prior;
+			totalPrior += prior;
+		}
+	}
+
+	if (totalPrior <= 0.) {
+		totalPrior = 1.;
+	}
+
+	for (size_t k = 0; k < relations.size(); k++) {
+		relations[k].second /= totalPrior;
+	}
+
+	for (size_t i = 0; i < nodes.size(); i++) {
+		if (nodes[i].type() == dai::ACTION) {
+			actions.push_back(NodeProbabilityPair(i, nodePriors[i] / totalPrior));
+
+		} else if (nodes[i].type() == dai::OBJECT) {
+			objects.push_back(NodeProbabilityPair(i, nodePriors[i] / totalPrior));
+		}
+	}
+
+}
+
+
 void ObjectActionRecognizer::constructNetwork(const ObjectDistanceMap& sceneObjects, const bool& useCounts /* = false */) {
+	turnStart = boost::posix_time::microsec_clock::universal_time();
+
 	// Initialize global factor count
 	factorCount = 0;
+	factorEndpoints.clear();
 
 	// Initialize global variable node count
 	nodeCount = 0;
@@ -561,272 +683,347 @@ void ObjectActionRecognizer::constructNetwork(const ObjectDistanceMap& sceneObje
 	}	
 	
 	/*
-	 * Create the object-action intention network
+	 * Create the object-action intention network and run inference on it. This is
+	 * the only inference run for the scene; query generators and selectors read the
+	 * same results through getSceneInference()
 	 */
-	theNetwork = dai::FactorGraph(allFactors);	
-
-	
-	/*
-	 * Instantiate the inference algorithm
-	 */
-	dai::PropertySet infProps;
-	infProps.set("tol", 0.00000001);
-	infProps.set("logdomain", true);
-	infProps.set("updates", std::string("SEQMAX"));
-	infProps.set("inference", std::string("MAXPROD"));
-
-	inferenceAlgo = newInfAlg("BP", theNetwork, infProps );
-	inferenceAlgo->init();
-	inferenceAlgo->run();
-
 	if (!useCounts) {
-		getMarginalProbabilities();
+		inferWithinBudget();
 	} else {
+		// The counts do not depend on the beliefs, so inference is not run
+		scene.reset(new SceneInference(allFactors, SceneInference::defaultProperties(), false));
+		scoringTier = COUNT_SCORES;
 		getNumericalProbabilities();
 	}
 	
 }
 
 
-void ObjectActionRecognizer::generateMarkovBasedQuerySet() {
-	int queryIdx = 0;
-	queries.clear();
+void ObjectActionRecognizer::inferWithinBudget() {
+	dai::PropertySet props = SceneInference::defaultProperties();
 
-	// Add the action queries to the set
-	for (size_t i = 0; i < actions.size(); i++) {			
-		Query q (queryIdx, actions[i].second, -1, actions[i].first, "", allNodes[actions[i].first].name);
-		q.type = ACTION_QUERY;
-		queries.push_back(q);
-		queryIdx++;
-			
-	}
+	if (latencyBudget > 0.) {
+		const double remaining = latencyBudget - getTurnMillis();
+		const double sweepMillis = getCostModel().estimateSweepMillis(allFactors.size());
 
-	// Add the object queries to the set
-	for (size_t j = 0; j < objects.size(); j++) {
-		Query q (queryIdx, objects[j].second, objects[j].first, -1, allNodes[objects[j].first].name, "");
-		q.type = OBJECT_QUERY;
-		queries.push_back(q);				
-		queryIdx++;
-			
-	}				
-
-	// Add the <object-action> queries to the set
-	for (size_t i = 0; i < relations.size(); i++) {
-		std::string objName, actionName;
-		size_t objIdx, actionIdx;
-		size_t factorIdx = relations[i].first;
-		std::vector<NetworkNode> nodes = theNetwork.factors()[factorIdx].vars().elements();
+		if (remaining <= 0.) {
+			scene.reset(new SceneInference(allFactors, props, false));
+			scoringTier = PRIOR_SCORES;
+			getPriorProbabilities();
+			return;
+		}
 
-		/*
-		 * All factors ONLY involve two variables, therefore in this case one is an action
-		 * and the other is an object. Thus, we handle these accordingly.
-		 */
-		assert(nodes.size() == 2);
-		if (nodes[0].type() == dai::ACTION) {
-			actionIdx = nodes[0].label();
-			objIdx = nodes[1].label();
-			actionName = actionNames[actionIdx];
-			objName = objectNames[objIdx];
-			
-		} else if (nodes[0].type() == dai::OBJECT) {
-			objIdx = nodes[0].label();
-			actionIdx = nodes[1].label();
-			objName = objectNames[objIdx];
-			actionName = actionNames[actionIdx];				
+		if (remaining < sweepMillis) {
+			scene.reset(new SceneInference(allFactors, props, false));
+			scoringTier = COUNT_SCORES;
+			getNumericalProbabilities();
+			return;
 		}
 
-		Query q(queryIdx, relations[i].second, objIdx, actionIdx, objName, actionName);
-		q.type = FULL_QUERY;
-		queries.push_back(q);
-		queryIdx++;
-			
+		// The deadline is only checked between sweeps, so one sweep is kept in reserve
+		props = SceneInference::anytimeProperties((remaining - sweepMillis) / 1000.);
 	}
 
-	std::sort(queries.begin(), queries.end(), QueryComparator());
+	const double inferenceStart = getTurnMillis();
+	scene.reset(new SceneInference(allFactors, props));
+	const double inferenceMillis = getTurnMillis() - inferenceStart;
+
+	// Update the estimated cost of a sweep, from which the tier of the later scenes of the cost model is chosen
+	getCostModel().recordInference(inferenceMillis, scene->getIterations(), allFactors.size());
+
+	scoringTier = scene->converged() ? FULL_INFERENCE : ANYTIME_INFERENCE;
+	getMarginalProbabilities();
 }
 
 
-void ObjectActionRecognizer::generateCountBasedQuerySet() {
-	int queryIdx = 0;
-	queries.clear();
+SceneCostModel& ObjectActionRecognizer::getCostModel() {
+	return costModel ? *costModel : localCostModel;
+}
 
-	// Add the action queries to the set
-	for (size_t i = 0; i < actions.size(); i++) {
-		Query q (queryIdx, actions[i].second, -1, actions[i].first, "", allNodes[actions[i].first].name);
-		q.type = ACTION_QUERY;
-		queries.push_back(q);
-		queryIdx++;
 
-	}
+double ObjectActionRecognizer::getTurnMillis() const {
+	return (boost::posix_time::microsec_clock::universal_time() - turnStart).total_microseconds() / 1000.;
+}
 
-	// Add the object queries to the set
-	for (size_t j = 0; j < objects.size(); j++) {
-		Query q (queryIdx, objects[j].second, objects[j].first, -1, allNodes[objects[j].first].name, "");
-		q.type = OBJECT_QUERY;
-		queries.push_back(q);
-		queryIdx++;
 
+bool ObjectActionRecognizer::getTemplatePair(const Query& q, size_t& objTemplateIdx, size_t& actTemplateIdx) const {
+	if (q.objectIndex < 0 || q.actionIndex < 0) {
+		return false;
 	}
 
-	// Add the <object-action> queries to the set
-	for (size_t i = 0; i < relations.size(); i++) {
-		std::string objName, actionName;
-		size_t objIdx, actionIdx;
-		size_t factorIdx = relations[i].first;
-		std::vector<NetworkNode> nodes = theNetwork.factors()[factorIdx].vars().elements();
-
-		/*
-		 * All factors ONLY involve two variables, therefore in this case one is an action
-		 * and the other is an object. Thus, we handle these accordingly.
-		 */
-		assert(nodes.size() == 2);
-		if (nodes[0].type() == dai::ACTION) {
-			actionIdx = nodes[0].label();
-			objIdx = nodes[1].label();
-			actionName = actionNames[actionIdx];
-			objName = objectNames[objIdx];
-
-		} else if (nodes[0].type() == dai::OBJECT) {
-			objIdx = nodes[0].label();
-			actionIdx = nodes[1].label();
-			objName = objectNames[objIdx];
-			actionName = actionNames[actionIdx];
-		}
+	if (templateQuerySet) {
+		objTemplateIdx = q.objectIndex;
+		actTemplateIdx = q.actionIndex;
+		return (objTemplateIdx < templateCompats.size() && actTemplateIdx < NUM_ACTIONS);
+	}
 
-		Query q(queryIdx, relations[i].second, objIdx, actionIdx, objName, actionName);
-		q.type = FULL_QUERY;
-		queries.push_back(q);
-		queryIdx++;
+	ObjectTemplateIndexMap::const_iterator obj = objectTemplateIndex.find(q.objectIndex);
+	ActionTemplateIndexMap::const_iterator act = actionTemplateIndex.find(q.actionIndex);
 
+	if (obj == objectTemplateIndex.end() || act == actionTemplateIndex.end()) {
+		return false;
 	}
 
-	std::sort(queries.begin(), queries.end(), CountsQueryComparator());
+	objTemplateIdx = obj->second;
+	actTemplateIdx = act->second;
+	return true;
+}
+
 
+void ObjectActionRecognizer::generateMarkovBasedQuerySet() {
+	generateSceneQuerySet(RANK_BY_SCORE);
+}
+
+
+void ObjectActionRecognizer::generateCountBasedQuerySet() {
+	generateSceneQuerySet(RANK_BY_TYPE);
 }
 
 
 void ObjectActionRecognizer::generateRandomQuerySetBasedOnScene() {
+	generateSceneQuerySet(SHUFFLE);
+}
+
+
+void ObjectActionRecognizer::generateSceneQuerySet(const QueryOrdering& ordering) {
 	int queryIdx = 0;
-	queries.clear();
+	std::vector<Query> querySet;
+
+	banditWeighted = false;
+
+	templateQuerySet = false;
+
+	querySet.reserve(actions.size() + objects.size() + relations.size() + 1);
 
-	// Add the action queries to the set
-	for (size_t i = 0; i < actions.size(); i++) {
-		Query q (queryIdx, actions[i].second, -1, actions[i].first, "", allNodes[actions[i].first].name);
+	// Add the action queries to the set, for the actions that some object of the scene affords
+	for (size_t i = 0; i < actions.size(); i++) {			
+		if (!affordances.isAfforded(actions[i].first)) {
+			continue;
+		}
+
+		Query q (queryIdx, actions[i].second, -1, actions[i].first, -1, nodeNameIds[actions[i].first]);
 		q.type = ACTION_QUERY;
-		queries.push_back(q);
+		querySet.push_back(q);
 		queryIdx++;
-
+			
 	}
 
 	// Add the object queries to the set
 	for (size_t j = 0; j < objects.size(); j++) {
-		Query q (queryIdx, objects[j].second, objects[j].first, -1, allNodes[objects[j].first].name, "");
+		Query q (queryIdx, objects[j].second, objects[j].first, -1, nodeNameIds[objects[j].first], -1);
 		q.type = OBJECT_QUERY;
-		queries.push_back(q);
+		querySet.push_back(q);				
 		queryIdx++;
-
-	}
+			
+	}				
 
 	// Add the <object-action> queries to the set
 	for (size_t i = 0; i < relations.size(); i++) {
-		std::string objName, actionName;
-		size_t objIdx, actionIdx;
-		size_t factorIdx = relations[i].first;
-		std::vector<NetworkNode> nodes = theNetwork.factors()[factorIdx].vars().elements();
-
 		/*
-		 * All factors ONLY involve two variables, therefore in this case one is an action
-		 * and the other is an object. Thus, we handle these accordingly.
+		 * All relations are <object, action> factors, whose nodes were recorded when
+		 * the factors were created
 		 */
-		assert(nodes.size() == 2);
-		if (nodes[0].type() == dai::ACTION) {
-			actionIdx = nodes[0].label();
-			objIdx = nodes[1].label();
-			actionName = actionNames[actionIdx];
-			objName = objectNames[objIdx];
-
-		} else if (nodes[0].type() == dai::OBJECT) {
-			objIdx = nodes[0].label();
-			actionIdx = nodes[1].label();
-			objName = objectNames[objIdx];
-			actionName = actionNames[actionIdx];
-		}
+		const FactorEndpoints& endpoints = factorEndpoints[relations[i].first];
+		const int objIdx = endpoints.objectLabel;
+		const int actionIdx = endpoints.actionLabel;
 
-		Query q(queryIdx, relations[i].second, objIdx, actionIdx, objName, actionName);
+		Query q(queryIdx, relations[i].second, objIdx, actionIdx, nodeNameIds[objIdx], nodeNameIds[actionIdx]);
 		q.type = FULL_QUERY;
-		queries.push_back(q);
+		querySet.push_back(q);
 		queryIdx++;
+			
 	}
 
-	std::random_shuffle(queries.begin(), queries.end());
+	state.nextQueryIndex = queryIdx;
+
+	switch (ordering) {
+		case RANK_BY_SCORE:
+			tieBreaks.assignKeys(querySet);
+
+			// Weight the scores by the acceptance of their query types sampled for this scene
+			if (typeBandit) {
+				banditContext = typeBandit->context(relations.size());
+				typeBandit->weigh(querySet, typeBandit->sample(banditContext));
+				banditWeighted = true;
+				banditAsked.assign(QueryTypeBandit::NUM_TYPES, 0);
+				banditInteractions = 0;
+			}
+
+			// Add the group query to the set
+			if (state.useGroupQueries) {
+				Query groupQuery;
+
+				if (state.createGroupQuery(querySet, groupQuery)) {
+					querySet.push_back(groupQuery);
+				}
+			}
+
+			state.assign(querySet, QueryComparator(), &affordances);
+
+			// Policies are only planned for fully inferred scenes, within the time left
+			if (scoringTier == FULL_INFERENCE && latencyBudget <= 0.) {
+				planQueries(querySet);
+			} else {
+				const double remaining = latencyBudget - getTurnMillis();
+
+				if (scoringTier == FULL_INFERENCE && remaining > 0.) {
+					planQueries(querySet, remaining);
+				} else {
+					planQueries(std::vector<Query>());
+				}
+			}
+			break;
+
+		case RANK_BY_TYPE:
+			tieBreaks.assignKeys(querySet);
+			state.assign(querySet, CountsQueryComparator(), &affordances);
+			break;
 
+		case SHUFFLE:
+			std::random_shuffle(querySet.begin(), querySet.end(), tieBreaks);
+			state.assign(querySet, QueryOrder(), &affordances);
+			break;
+	}
 }
 
 
 void ObjectActionRecognizer::generateRandomQuerySet() {
 	int queryIdx = 0;
-	queries.clear();
+	std::vector<Query> querySet;
+
+	banditWeighted = false;
 
-	for (size_t i = 0; i < objectActionMap.getNumOfObjects(); ++i) {
-		ObjectActionProperty oap = objectActionMap(i, 0);
-		if (!oap.objectName.empty()) {
+	// The queries of a random set refer to the templates directly
+	templateQuerySet = true;
+
+	ActionMask affordedActions = 0;
+
+	for (size_t i = 0; i < templateCompats.size(); ++i) {
+		if (templateCompats[i].actionMask != 0) {
 			/*
 			 * In the random case, we assume that there is only one
 			 * instance of an object for simplicity.
 			 */
-			std::string objName = oap.objectName + "1";
+			int objNameId = queryNames.intern(templateCompats[i].name + "1");
 
-			Query q (queryIdx, 1.0, i, -1, objName, "");
+			Query q (queryIdx, 1.0, i, -1, objNameId, -1);
 			q.type = OBJECT_QUERY;
-			queries.push_back(q);
+			querySet.push_back(q);
 			queryIdx++;
+
+			affordedActions |= templateCompats[i].actionMask;
 		}
 	}
 
-	for (size_t j = 0; j < objectActionMap.getNumOfActions(); ++j) {
-		ObjectActionProperty oap = objectActionMap(0, j);
-		if (!oap.actionName.empty()) {
-			std::string actionName = oap.actionName;
-			Query q (queryIdx, 1.0, -1, j, "", actionName);
+	for (size_t j = 0; j < NUM_ACTIONS; ++j) {
+		if (affordedActions & actionBit(j)) {
+			int actionNameId = queryNames.intern(ActionName()(static_cast<Action>(j)));
+			Query q (queryIdx, 1.0, -1, j, -1, actionNameId);
 			q.type = ACTION_QUERY;
-			queries.push_back(q);
+			querySet.push_back(q);
 			queryIdx++;
 		}
 	}
 
-	for (size_t i = 0; i < objectActionMap.getNumOfObjects(); ++i) {
-		for (size_t j = 0; j < objectActionMap.getNumOfActions(); ++j) {
-			ObjectActionProperty oap = objectActionMap(i, j);
-			if (!oap.objectName.empty() && !oap.actionName.empty()) {
-				std::string objectName = oap.objectName + "1";
-				std::string actionName = oap.actionName;
+	for (size_t i = 0; i < templateCompats.size(); ++i) {
+		for (size_t j = 0; j < NUM_ACTIONS; ++j) {
+			if (templateCompats[i].affords(j)) {
+				int objNameId = queryNames.intern(templateCompats[i].name + "1");
+				int actionNameId = queryNames.intern(ActionName()(static_cast<Action>(j)));
 
-				Query q(queryIdx, 1.0, i, j, objectName, actionName);
+				Query q(queryIdx, 1.0, i, j, objNameId, actionNameId);
 				q.type = FULL_QUERY;
-				queries.push_back(q);
+				querySet.push_back(q);
 				queryIdx++;
 			}
 		}
 	}
 
-	std::random_shuffle(queries.begin(), queries.end());
-
+	std::random_shuffle(querySet.begin(), querySet.end(), tieBreaks);
+	state.assign(querySet);
 }
 
 
 dai::FactorGraph ObjectActionRecognizer::getNetwork() const {
-	return theNetwork;
+	if (!scene) {
+		return dai::FactorGraph();
+	}
+	return scene->network();
+}
+
+
+SceneInferencePtr ObjectActionRecognizer::getSceneInference() const {
+	return scene;
 }
 
 
 void ObjectActionRecognizer::writeTemplates() {
-	objectActionMap.writeMap(objectActionMapFileName);
+	endSession();
+
+	if (!mapPreloaded && journal == NULL) {
+		objectActionMap.writeMap(objectActionMapFileName);
+	}
+}
+
+
+void ObjectActionRecognizer::endSession() {
+	if (journal) {
+		journal->append(templateUpdates);
+	}
+
+	if (!templateUpdates.empty()) {
+		getCostModel().invalidateTemplatePriors();
+	}
+
+	templateUpdates.apply(objectActionMap);
+
+	if (journal && journal->needsCompaction()) {
+		journal->compact(objectActionMap);
+	}
+}
+
+
+void ObjectActionRecognizer::setTemplateJournal(TemplateJournal* journal) {
+	this->journal = journal;
+
+	if (journal) {
+		journal->load(objectActionMap);
+		getCostModel().invalidateTemplatePriors();
+	}
+}
+
+
+void ObjectActionRecognizer::setNegativeLearningRate(const double& rate) {
+	negativeLearningRate = (rate > 0.) ? rate : 0.;
+}
+
+
+double ObjectActionRecognizer::getNegativeLearningRate() const {
+	return negativeLearningRate;
+}
+
+
+void ObjectActionRecognizer::setIntentionHistory(IntentionHistory* history) {
+	this->history = history;
 }
 
 
 void ObjectActionRecognizer::resetTemplates() {
+	templateUpdates.clear();
 	objectActionMap.resetToDefault();
-	writeTemplates();
+	getCostModel().invalidateTemplatePriors();
+
+	// The journaled sessions no longer apply, so they are folded into the reset map
+	if (journal) {
+		journal->compact(objectActionMap);
+	} else {
+		writeTemplates();
+	}
+}
+
+
+const ObjectActionMap& ObjectActionRecognizer::getObjectActionMap() const {
+	return objectActionMap;
 }
 
 
@@ -849,7 +1046,7 @@ void ObjectActionRecognizer::updateTemplatesUsingObservations() {
 				 * Store the factors of each instance of this i'th category
 				 */
 				for (size_t k = 0; k < instanceFactorIndices.size(); k++) {
-					instanceFactors.push_back(theNetwork.factor(instanceFactorIndices[k]));
+					instanceFactors.push_back(scene->network().factor(instanceFactorIndices[k]));
 				}
 
 				allInstancesFactors.push_back(instanceFactors);
@@ -921,175 +1118,151 @@ void ObjectActionRecognizer::updateTemplatesUsingObservations() {
 void ObjectActionRecognizer::selectQuery(){
 	/*
 	 * For MAP-based queries, the suggested query is always at the top of
-	 * the list because they are listed in descending order of probability
+	 * the ranking because they are ranked in descending order of probability,
+	 * unless a planned question policy is being followed or the queries are
+	 * selected by looking ahead. The query may already have been selected
+	 * speculatively.
 	 */
-	currentQuery = queries[0];
+	if (!state.querySelected) {
+		state.select(policy.get(), plannedQueries, lookahead);
+	}
 	
 }
 
 
-std::vector<Query> ObjectActionRecognizer::getQueries() const {
-	return queries;
+void ObjectActionRecognizer::setQueryPlanner(QueryPlanner* planner) {
+	this->planner = planner;
 }
 
 
-Query ObjectActionRecognizer::getCurrentQuery() const {
-	return currentQuery;
+void ObjectActionRecognizer::setQueryLookahead(QueryLookahead* lookahead) {
+	this->lookahead = lookahead;
 }
 
 
-bool ObjectActionRecognizer::evaluate(const bool& wasSelected) {
-	ObjectActionPair observedVars;
-	bool intentionRecognized = false;
-	
-	if (wasSelected == true) {	
-		/*
-		 * Query Accepted
-		 */
-		if (currentQuery.type == FULL_QUERY) {
-			/*
-			 * If the user responds positively to a full query, which is a query involving
-			 * an object and an action, we are done. There is no need to ask them any more
-			 * questions. We simply 'perform' the chosen action on the chosen object.
-			 *
-			 */
-			if (currentQuery.hasAction) {
-				observedVars.actionIndex = currentQuery.actionIndex;					
-			}
-			if (currentQuery.hasObject) {
-				observedVars.objectIndex = currentQuery.objectIndex;										
-			}				
-								
-			intentionRecognized = true;			
+void ObjectActionRecognizer::planQueries(const std::vector<Query>& querySet, const double& maxMillis) {
+	speculation.cancel();
+	policy.reset();
+	state.policyStep = -1;
+	plannedQueries.clear();
 
-		} else if (currentQuery.type == ACTION_QUERY) {
-			/*
-			 * If the user responds positively to an action query, which is a query 
-			 * only involving an action, we prune the current query set to determine only
-			 * those queries that involve the chosen action together with an object. We would 
-			 * then suggest new queries which would now include the objects that afford the 
-			 * selected action.
-			 */
-			std::vector<Query> pruned;
-			for (size_t i = 0; i < queries.size(); i++) {
-				if (queries[i].hasObject && queries[i].hasAction && queries[i].actionIndex == currentQuery.actionIndex) {
-					pruned.push_back(queries[i]);
-				}
-			}
-			
-			queries.clear();
-			queries = pruned;
-			currentQuery = queries[0];
+	if (planner == NULL || querySet.empty()) {
+		return;
+	}
 
-			if (currentQuery.hasAction) {
-				observedVars.actionIndex = currentQuery.actionIndex;
-			}			
+	QueryPolicyPtr plannedPolicy = planner->plan(querySet, queryNames, &state.groups, maxMillis);
 
-		} else if (currentQuery.type == OBJECT_QUERY) {
-			/*
-			 * If the user responds positively to an object query, which is a query 
-			 * only involving an object, we prune the current query set to determine only
-			 * those queries that involve the chosen object together with an action. We would 
-			 * then suggest new queries which would now include the actions that the selected
-			 * object affords.
-			 */
-			std::vector<Query> pruned;
-			for (size_t i = 0; i < queries.size(); i++) {
-				if (queries[i].hasAction && queries[i].hasObject && queries[i].objectIndex == currentQuery.objectIndex) {
-					pruned.push_back(queries[i]);
-				}
+	if (!plannedPolicy->nodes.empty()) {
+		for (size_t i = 0; i < querySet.size(); i++) {
+			if (querySet[i].index >= static_cast<int>(plannedQueries.size())) {
+				plannedQueries.resize(querySet[i].index + 1);
 			}
-			queries.clear();
-			queries = pruned;
-			currentQuery = queries[0];
-
-			if (currentQuery.hasObject) {
-				observedVars.objectIndex = currentQuery.objectIndex;										
-			}			
+			plannedQueries[querySet[i].index] = querySet[i];
 		}
 
+		policy = plannedPolicy;
+		state.policyStep = 0;
+	}
+}
+
+
+std::vector<Query> ObjectActionRecognizer::getQueries() const {
+	return state.queries.ranked();
+}
+
+
+std::vector<Query> ObjectActionRecognizer::getTopQueries(const size_t& k) const {
+	return state.queries.peek(k);
+}
+
+
+size_t ObjectActionRecognizer::getNumQueries() const {
+	return state.queries.size();
+}
+
+
+Query ObjectActionRecognizer::getCurrentQuery() const {
+	return state.currentQuery;
+}
+
+
+std::string ObjectActionRecognizer::getQuestion(const Query& q) const {
+	if (q.type == GROUP_QUERY) {
+		return state.groups.question(q, queryNames);
+	}
+	return queryNames.question(q);
+}
+
+
+void ObjectActionRecognizer::renderQuestion(const Query& q, QuestionBuffer& buffer) const {
+	if (q.type == GROUP_QUERY) {
+		state.groups.render(q, queryNames, buffer);
 	} else {
-		/*
-		 * Query Rejected
-		 */
-		if (currentQuery.type == FULL_QUERY) {
-			/*
-			 * Remove the rejected full query from the query list as well as orphaned
-			 * object or action queries as a result of the rejection of this full query
-			 */
-			std::vector<Query> pruned;
-			std::vector<int> orphans;
-
-			for (size_t i = 0; i < queries.size(); i++) {
-				if (queries[i].index != currentQuery.index) {
-					if (queries[i].type == OBJECT_QUERY && queries[i].objectIndex == currentQuery.objectIndex) {							
-						orphans.push_back(queries[i].index);
-					}
-					else if (queries[i].type == ACTION_QUERY && queries[i].actionIndex == currentQuery.actionIndex) {
-						orphans.push_back(queries[i].index);
-					}
-				}
-			}
-			for (size_t j = 0; j < orphans.size(); j++) {
-				for (size_t k = 0; k < queries.size(); k++) {
-					if (queries[k].index == orphans[j]) {
-						queries.erase(queries.begin() + k);
-						break;
-					}
-				}
-			}
-				
-			for (size_t i = 0; i < queries.size(); i++) {
-				if (queries[i].index != currentQuery.index) {						
-					pruned.push_back(queries[i]);
-				}
-			}
-			queries.clear();
-			queries = pruned;
-			currentQuery = queries[0];
+		queryNames.render(q, buffer);
+	}
+}
 
-			if (currentQuery.hasAction) {
-				observedVars.actionIndex = currentQuery.actionIndex;										
-			}
-			
-			if (currentQuery.hasObject) {
-				observedVars.objectIndex = currentQuery.objectIndex;										
-			}
-						
 
-		} else if (currentQuery.type == ACTION_QUERY) {
-			/*
-			 * Remove the rejected action query, along with any other queries involving
-			 * the action.
-			 */
-			std::vector<Query> pruned;
-			for (size_t i = 0; i < queries.size(); i++) {
-				if (queries[i].actionIndex != currentQuery.actionIndex) {
-					pruned.push_back(queries[i]);
-				}
-			}
-				
-			queries.clear();
-			queries = pruned;
-			currentQuery = queries[0];
-			
+const QueryNameTable& ObjectActionRecognizer::getQueryNames() const {
+	return queryNames;
+}
 
-		} else if (currentQuery.type == OBJECT_QUERY) {
-			/*
-			 * Remove the rejected object query, along with any other queries involving
-			 * the object.
-			 */
-			std::vector<Query> pruned;
-			for (size_t i = 0; i < queries.size(); i++) {
-				if (queries[i].objectIndex != currentQuery.objectIndex) {
-					pruned.push_back(queries[i]);
-				}
-			}
-				
-			queries.clear();
-			queries = pruned;
-			currentQuery = queries[0];
-			
+
+const QueryGroupTable& ObjectActionRecognizer::getQueryGroups() const {
+	return state.groups;
+}
+
+
+const SceneAffordances& ObjectActionRecognizer::getSceneAffordances() const {
+	return affordances;
+}
+
+
+void ObjectActionRecognizer::setUseGroupQueries(const bool& useGroups) {
+	state.useGroupQueries = useGroups;
+}
+
+
+void ObjectActionRecognizer::setLatencyBudget(const double& millis) {
+	latencyBudget = (millis > 0.) ? millis : 0.;
+}
+
+
+double ObjectActionRecognizer::getLatencyBudget() const {
+	return latencyBudget;
+}
+
+
+void ObjectActionRecognizer::setSceneCostModel(SceneCostModel* model) {
+	costModel = model;
+}
+
+
+ObjectActionRecognizer::ScoringTier ObjectActionRecognizer::getScoringTier() const {
+	return scoringTier;
+}
+
+
+bool ObjectActionRecognizer::evaluate(const bool& wasSelected) {
+	ObjectActionPair observedVars;
+	const Query answered = state.currentQuery;
+	bool intentionRecognized = false;
+
+	if (!speculation.take(answered, wasSelected, state, intentionRecognized)) {
+		speculation.cancel();
+		intentionRecognized = state.applyAnswer(wasSelected, policy.get());
+	}
+
+	// Reward the query types of a session ranked by the bandit by how quickly it is resolved
+	if (typeBandit && banditWeighted) {
+		if (QueryTypeBandit::isLearned(answered.type)) {
+			banditAsked[answered.type]++;
+		}
+		banditInteractions++;
+
+		if (intentionRecognized) {
+			typeBandit->recordSession(banditContext, banditAsked, banditInteractions);
+			banditWeighted = false;
 		}
 	}
 	
@@ -1097,38 +1270,211 @@ bool ObjectActionRecognizer::evaluate(const bool& wasSelected) {
 		size_t objTemplateIdx;
 		size_t actTemplateIdx;
 
+		recordCommitOutcome(answered.index == topIntention.index);
+
 		/*
-		 * Update the factor template that coincides with the recognized intention
+		 * The user accepted a full query, which involves both an object and an action
 		 */
-		if (observedVars.objectIndex >= 0 && observedVars.actionIndex >= 0) {
-			objTemplateIdx = objectTemplateIndex[observedVars.objectIndex];
-			actTemplateIdx = actionTemplateIndex[observedVars.actionIndex];
-			objectActionMap.updateMap(objTemplateIdx, actTemplateIdx);
+		if (answered.hasAction) {
+			observedVars.actionIndex = answered.actionIndex;					
+		}
+		if (answered.hasObject) {
+			observedVars.objectIndex = answered.objectIndex;										
+		}				
+
+		/*
+		 * Update the factor template that coincides with the recognized intention when
+		 * the session ends
+		 */
+		if (observedVars.objectIndex >= 0 && observedVars.actionIndex >= 0
+			&& getTemplatePair(answered, objTemplateIdx, actTemplateIdx))
+		{
+			templateUpdates.add(objTemplateIdx, actTemplateIdx, objectActionMap.getLambda());
+
+			if (history) {
+				history->record(objTemplateIdx, actTemplateIdx);
+			}
 		}		
+
+	} else if (!wasSelected && answered.type == FULL_QUERY && negativeLearningRate > 0.) {
+		/*
+		 * The user rejected this <object, action> pair, so it becomes less compatible
+		 */
+		size_t objTemplateIdx;
+		size_t actTemplateIdx;
+
+		if (getTemplatePair(answered, objTemplateIdx, actTemplateIdx)) {
+			templateUpdates.add(objTemplateIdx, actTemplateIdx, -negativeLearningRate);
+		}
 	}
 
 	return intentionRecognized;
 }
 
 
+bool ObjectActionRecognizer::confirmIntention(const Query& intention) {
+	if (intention.type != FULL_QUERY) {
+		fprintf(stderr, "ObjectActionRecognizer Error: Only full queries can be confirmed as intentions!\n");
+		return false;
+	}
+
+	speculation.cancel();
+	state.currentQuery = intention;
+
+	return evaluate(true);
+}
+
+
+void ObjectActionRecognizer::speculate() {
+	if (!state.querySelected) {
+		selectQuery();
+	}
+
+	speculation.start(state, policy.get(), plannedQueries, lookahead);
+}
+
+
+std::vector<Query> ObjectActionRecognizer::selectQueries(const size_t& k) {
+	// Only the full queries are ranked, and only as deep as k
+	presentedQueries = state.queries.peek(k, FULL_QUERY);
+
+	return presentedQueries;
+}
+
+
+bool ObjectActionRecognizer::evaluateChoice(const int& choice) {
+	if (choice >= static_cast<int>(presentedQueries.size()) || choice < NO_CHOICE) {
+		fprintf(stderr, "ObjectActionRecognizer Error: Choice %d is not one of the presented queries!\n", choice);
+		return false;
+	}
+
+	if (choice != NO_CHOICE) {
+		state.currentQuery = presentedQueries[choice];
+		presentedQueries.clear();
+
+		return evaluate(true);
+	}
+
+	/*
+	 * None of the presented queries was chosen, so every one of them is rejected
+	 */
+	for (size_t i = 0; i < presentedQueries.size(); i++) {
+		state.currentQuery = presentedQueries[i];
+		evaluate(false);
+	}
+	presentedQueries.clear();
+
+	if (!state.queries.empty()) {
+		state.currentQuery = state.queries.top();
+	}
+
+	return false;
+}
+
+
+void ObjectActionRecognizer::setAutoCommitPolicy(AutoCommitPolicy* policy) {
+	this->autoCommit = policy;
+}
+
+
+void ObjectActionRecognizer::setQueryTypeBandit(QueryTypeBandit* bandit) {
+	this->typeBandit = bandit;
+	banditWeighted = false;
+}
+
+
+bool ObjectActionRecognizer::tryAutoCommit() {
+	double total = 0.;
+	double runnerUp = 0.;
+
+	committed = false;
+	sessionConfidence = -1.;
+	topIntention = Query();
+
+	if (autoCommit == NULL) {
+		return false;
+	}
+
+	// Only the top two scores and the total are needed, so the queries are not ranked
+	const std::vector<Query> candidates = state.queries.unordered();
+
+	for (size_t i = 0; i < candidates.size(); i++) {
+		if (candidates[i].type == FULL_QUERY) {
+			const Query& q = candidates[i];
+			total += q.score;
+
+			if (topIntention.index < 0 || q.score > topIntention.score
+					|| (q.score == topIntention.score && q.index < topIntention.index)) {
+				runnerUp = (topIntention.index < 0) ? 0. : topIntention.score;
+				topIntention = q;
+			} else if (q.score > runnerUp) {
+				runnerUp = q.score;
+			}
+		}
+	}
+
+	if (topIntention.index < 0 || total <= 0.) {
+		return false;
+	}
+
+	sessionConfidence = autoCommit->confidence(topIntention.score / total, runnerUp / total);
+	committed = autoCommit->shouldCommit(sessionConfidence);
+
+	if (committed) {
+		state.currentQuery = topIntention;
+	}
+
+	return committed;
+}
+
+
+bool ObjectActionRecognizer::confirmCommit(const bool& accepted) {
+	if (!committed) {
+		fprintf(stderr, "ObjectActionRecognizer Error: No intention was committed to!\n");
+		return false;
+	}
+
+	state.currentQuery = topIntention;
+
+	if (!accepted) {
+		recordCommitOutcome(false);
+	}
+
+	return evaluate(accepted);
+}
+
+
+void ObjectActionRecognizer::recordCommitOutcome(const bool& topWasCorrect) {
+	if (autoCommit != NULL && sessionConfidence >= 0.) {
+		autoCommit->record(sessionConfidence, topWasCorrect, committed);
+		sessionConfidence = -1.;
+	}
+}
+
+
 void ObjectActionRecognizer::writeNetworkToFile() {
+	if (!scene) {
+		return;
+	}
+
+	const dai::FactorGraph& theNetwork = scene->network();
 	theNetwork.WriteToFile("CurrentScene.fg");
 
 	std::ofstream os;
 	os.open("CurrentScene.dot");
 	dai::GraphAL markov = theNetwork.MarkovGraph();		
 
-	os << "graph GraphAL  {" << std::endl;
-	os << "node[shape=circle,width=1.0,fixedsize=true];" << std::endl;
-	for( size_t n = 0; n < markov.nrNodes(); n++ ) {
-		os << "\t\"" << theNetwork.var(n).name() << "\";" << std::endl;
-	}
-	for( size_t n1 = 0; n1 < markov.nrNodes(); n1++ ) {
-		BOOST_FOREACH( const dai::Neighbor &n2, markov.nb(n1) )
-		if( n1 < n2 ) {
-			os << "\t\"" << theNetwork.var(n1).name() << "\" -- \"" << theNetwork.var(n2).name() << "\";" << std::endl;
-		}
-	}
+	os << "graph GraphAL  {" << std::endl;
+	os << "node[shape=circle,width=1.0,fixedsize=true];" << std::endl;
+	for( size_t n = 0; n < markov.nrNodes(); n++ ) {
+		os << "\t\"" << theNetwork.var(n).name() << "\";" << std::endl;
+	}
+	for( size_t n1 = 0; n1 < markov.nrNodes(); n1++ ) {
+		BOOST_FOREACH( const dai::Neighbor &n2, markov.nb(n1) )
+		if( n1 < n2 ) {
+			os << "\t\"" << theNetwork.var(n1).name() << "\" -- \"" << theNetwork.var(n2).name() << "\";" << std::endl;
+		}
+	}
 	os << "}" << std::endl;
 }
 
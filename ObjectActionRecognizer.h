@@ -1,64 +1,81 @@
-/**
- * Software License Agreement (BSD License)
- *
- *  Object Action Recognition
- *  Copyright (c) 2013, Kester Duncan
- *
- *  All rights reserved.
- *
- *  Redistribution and use in source and binary forms, with or without
- *  modification, are permitted provided that the following conditions
- *  are met:
- *
- *   * Redistributions of source code must retain the above copyright
- *     notice, this list of conditions and the following disclaimer.
- *   * Redistributions in binary form must reproduce the above
- *     copyright notice, this list of conditions and the following
- *     disclaimer in the documentation and/or other materials provided
- *     with the distribution.
- *
- *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
- *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
- *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
- *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
- *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
- *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
- *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
- *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
- *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
- *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
- *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
- *  POSSIBILITY OF SUCH DAMAGE.
- *
- *	\file ObjectActionRecognizer.h
- *	\brief Administers the full object-action recognition process
- *	\author	Kester Duncan
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file ObjectActionRecognizer.h
+ *	\brief Administers the full object-action recognition process
+ *	\author	Kester Duncan
  */
 #ifndef OBJECT_ACTION_RECOGNIZER_H_
 #define OBJECT_ACTION_RECOGNIZER_H_
 
 
 #include <cstdlib>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <dai/daialg.h>
 #include "OARTypes.h"
 #include "Query.hpp"
+#include "QueryHeap.hpp"
+#include "QueryRanking.hpp"
+#include "QueryNameTable.hpp"
+#include "QueryGroupTable.hpp"
+#include "QueryPlanner.h"
+#include "QueryLookahead.hpp"
+#include "AutoCommitPolicy.hpp"
+#include "QueryTypeBandit.hpp"
+#include "QueryState.hpp"
+#include "SpeculativeEvaluator.hpp"
+#include "SceneInference.hpp"
+#include "SceneAffordances.hpp"
 #include "ObjectActionMap.h"
 #include "ObjectActionCountMap.hpp"
+#include "TemplateUpdateBuffer.hpp"
+#include "TemplateJournal.hpp"
+#include "IntentionHistory.hpp"
+#include "SceneCostModel.hpp"
 
 
 
 /**
- * \brief Namespace that encapsulates all of the functions and types relevant for object
+ * \brief Namespace that encapsulates all of the functions and types relevant for object
  * action recognition / human intention recognition
  */
 namespace oar {
 
 
 /**
- * \brief Class to perform scene-dependent human intention recognition
- * 
+ * \brief Class to perform scene-dependent human intention recognition
+ * 
  * Determines the object that is most likely to be manipulated and the
- * action most likely to be performed on the object using a Markov Networks.
+ * action most likely to be performed on the object using a Markov Networks.
  *
  */
 class ObjectActionRecognizer {
@@ -66,17 +83,46 @@ class ObjectActionRecognizer {
 public:
 	/// Constructs using the provided template map file name with the specified learning rate or the default values
 	ObjectActionRecognizer(const std::string& oaMapName = "ObjectActionMap.map", const double& learningRate = 1.0f);
+
+	/**
+	 * \brief Constructs using a template map that has already been loaded, e.g. one shared
+	 * by many sessions. The map is copied and templates are not written to any file.
+	 */
+	ObjectActionRecognizer(const ObjectActionMap& oaMap, const double& learningRate = 1.0f);
+
+	/**
+	 * \brief Constructs with the template map loaded through \c journal, so that the map
+	 * file is read once, with the journaled sessions replayed (see setTemplateJournal())
+	 */
+	ObjectActionRecognizer(TemplateJournal* journal, const double& learningRate = 1.0f);
 	
 	/// Destructor
-	~ObjectActionRecognizer();
-
-	/// Reinitialize variables and data
-	void reinitialize();
-
+	~ObjectActionRecognizer();
 
-	/**
-	 * \name Construction
-	 * @{
+	/// Reinitialize variables and data
+	void reinitialize();
+
+	/// Reseeds the stream that breaks ties between queries and shuffles random query sets
+	void setSeed(const unsigned int& seed);
+
+	/// Gets the seed of the current session, which reproduces its query rankings
+	unsigned int getSeed() const;
+
+	/// Scorers that can score the queries of a scene, from the most to the least accurate
+	enum ScoringTier {
+		FULL_INFERENCE,			///< Belief propagation run until it converged
+		ANYTIME_INFERENCE,		///< Belief propagation stopped before it converged, e.g. at the deadline
+		COUNT_SCORES,			///< Frequencies of the scene objects and actions (see getNumericalProbabilities)
+		PRIOR_SCORES			///< Template compatibilities of the <object, action> pairs, without inference
+	};
+
+	/// Gets a printable name of \c tier
+	static const char* getScoringTierName(const ScoringTier& tier);
+
+
+	/**
+	 * \name Construction
+	 * @{
 	 */
 
 	/**
@@ -88,29 +134,68 @@ public:
 	/**
 	 * \brief Generate a query set based on Markov Networks and Recursive Bayesian Learning information
 	 */
-	void generateMarkovBasedQuerySet();
-
-	/**
-	 * \brief Generate a query set based on frequency counts of current objects and actions in the scene
-	 */
-	void generateCountBasedQuerySet();
-
-	/**
-	 * \brief Generate a random query set based on all possible objects and actions
-	 */
-	void generateRandomQuerySet();
-
-	/**
-	 * \brief Generate a random query set based on objects and actions given by the scene
-	 */
+	void generateMarkovBasedQuerySet();
+
+	/**
+	 * \brief Generate a query set based on frequency counts of current objects and actions in the scene
+	 */
+	void generateCountBasedQuerySet();
+
+	/**
+	 * \brief Generate a random query set based on all possible objects and actions
+	 */
+	void generateRandomQuerySet();
+
+	/**
+	 * \brief Generate a random query set based on objects and actions given by the scene
+	 */
 	void generateRandomQuerySetBasedOnScene();
-
+
+
+	/**
+	 * \brief Adds a group query ("is it one of these?") to Markov-based query sets. The group
+	 * splits the probability mass of the remaining intentions roughly in half and is
+	 * regenerated after every answer, so the candidates are ruled out about half at a time.
+	 */
+	void setUseGroupQueries(const bool& useGroups);
+
+	/**
+	 * \brief Limits constructNetwork() followed by generateMarkovBasedQuerySet() to \c millis
+	 * milliseconds per turn; 0 removes the limit
+	 *
+	 * When the remaining time does not allow belief propagation to converge, the scene
+	 * is scored by the most accurate tier that fits: belief propagation stopped at the
+	 * deadline, the scene counts or the template priors. The cost of an inference sweep
+	 * is measured on every scene so that the tier can be chosen before it is run; see
+	 * setSceneCostModel() to carry the measurements over to the next scenes.
+	 * Queries are not planned for scenes that were not fully inferred, and the planner
+	 * only searches for as long as the budget allows.
+	 * \ingroup Construction
+	 */
+	void setLatencyBudget(const double& millis);
+
+	/// Gets the latency budget per turn in milliseconds, or 0 if there is none
+	double getLatencyBudget() const;
+
+	/**
+	 * \brief Keeps the measured cost of inference and the template priors in \c model,
+	 * which is owned by the caller so that they carry over to the recognizers of the next
+	 * scenes. NULL keeps them in the recognizer, for its scenes only.
+	 * \ingroup Construction
+	 */
+	void setSceneCostModel(SceneCostModel* model);
+
+	/**
+	 * \brief Gets the tier that scored the queries of the current scene
+	 * \ingroup Construction
+	 */
+	ScoringTier getScoringTier() const;
 
 	/** @} */
 
-	/**
-	 * \name Interaction    
-	 * @{
+	/**
+	 * \name Interaction    
+	 * @{
 	 */ 
 	
 	/**
@@ -120,44 +205,228 @@ public:
 	void selectQuery();
 
 	/**
-	 * \brief Gets the current query list
+	 * \brief Follows the question policy planned by \c planner for Markov-based query sets
+	 * instead of always proposing the highest ranked query. The planner is owned by the
+	 * caller, so that its cached policies outlive the recognizer; NULL disables planning.
+	 * \ingroup Interaction
+	 */
+	void setQueryPlanner(QueryPlanner* planner);
+
+	/**
+	 * \brief Selects queries by their expected cost over the next two answers using
+	 * \c lookahead, which is owned by the caller. A planned policy takes precedence;
+	 * NULL disables the lookahead.
+	 * \ingroup Interaction
+	 */
+	void setQueryLookahead(QueryLookahead* lookahead);
+
+	/**
+	 * \brief Gets the current query list in ranked order
 	 * \ingroup Interaction
 	 */
 	std::vector<Query> getQueries() const;
 
+	/**
+	 * \brief Gets the \c k highest ranked queries of the current query list, best first,
+	 * without ranking the rest
+	 * \ingroup Interaction
+	 */
+	std::vector<Query> getTopQueries(const size_t& k) const;
+
+	/**
+	 * \brief Gets the number of queries left in the current query list
+	 * \ingroup Interaction
+	 */
+	size_t getNumQueries() const;
+
 	/**
 	 * \brief Get the highest probable query
 	 * \ingroup Interaction
 	 */
 	Query getCurrentQuery() const;
 
+	/**
+	 * \brief Renders the human-readable question for the query \c q
+	 * \ingroup Interaction
+	 */
+	std::string getQuestion(const Query& q) const;
+
+	/**
+	 * \brief Renders the human-readable question for the query \c q into \c buffer
+	 * without allocating
+	 * \ingroup Interaction
+	 */
+	void renderQuestion(const Query& q, QuestionBuffer& buffer) const;
+
+	/**
+	 * \brief Gets the table of object and action names that the queries refer to
+	 * \ingroup Interaction
+	 */
+	const QueryNameTable& getQueryNames() const;
+
+	/**
+	 * \brief Gets the table of object groups that group queries refer to
+	 * \ingroup Interaction
+	 */
+	const QueryGroupTable& getQueryGroups() const;
+
+	/**
+	 * \brief Gets the object instances of the current scene that afford each action
+	 * \ingroup Interaction
+	 */
+	const SceneAffordances& getSceneAffordances() const;
+
 	/**
 	 * \brief Evaluates the choice a user makes
 	 * \ingroup Interaction
 	 */
 	bool evaluate(const bool& wasSelected);
 
+	/**
+	 * \brief Records that \c intention, a full query of the current query set, is the
+	 * user's, as if the user had accepted it when it was proposed. The template update
+	 * is buffered like that of any accepted query (see endSession()).
+	 * \return False if \c intention is not a full query
+	 * \ingroup Interaction
+	 */
+	bool confirmIntention(const Query& intention);
+
+	/**
+	 * \brief Starts computing the outcomes of both answers to the current query in the
+	 * background. Call it after selectQuery(), while the question is displayed; the
+	 * outcome of the real answer is then taken by evaluate() as soon as it is ready.
+	 * \ingroup Interaction
+	 */
+	void speculate();
+
+	/**
+	 * \brief Selects the \c k highest ranked full queries to be presented to the user at once
+	 *
+	 * Full queries are mutually exclusive, so the user picks at most one of them.
+	 * \ingroup Interaction
+	 */
+	std::vector<Query> selectQueries(const size_t& k);
+
+	/**
+	 * \brief Evaluates the choice a user makes among the queries returned by selectQueries()
+	 * \param choice The position of the chosen query, or \c NO_CHOICE if none was chosen
+	 * \return True if the intention was recognized
+	 * \ingroup Interaction
+	 */
+	bool evaluateChoice(const int& choice);
+
+	/// Choice indicating that none of the presented queries was chosen
+	static const int NO_CHOICE = -1;
+
+	/**
+	 * \brief Decides with \c policy, which is owned by the caller, whether to commit to
+	 * the top intention of a scene without asking. NULL disables auto-commit.
+	 * \ingroup Interaction
+	 */
+	void setAutoCommitPolicy(AutoCommitPolicy* policy);
+
+	/**
+	 * \brief Commits to the top full query of the current query set if the auto-commit
+	 * policy deems the posterior decisive. Must be called after generating the query set.
+	 *
+	 * The committed query becomes the current query; the user is not asked about it but
+	 * may reject it, which is reported through confirmCommit().
+	 * \return True if the recognizer committed
+	 * \ingroup Interaction
+	 */
+	bool tryAutoCommit();
+
+	/**
+	 * \brief Reports whether the user let the committed intention stand
+	 * \return True if the intention was recognized; otherwise the committed query has
+	 * been rejected and questioning continues
+	 * \ingroup Interaction
+	 */
+	bool confirmCommit(const bool& accepted);
+
+	/**
+	 * \brief Biases the ranking of generateMarkovBasedQuerySet() towards the query types
+	 * that lead to a quick recognition for the user, as learned by \c bandit, which is
+	 * owned by the caller. Every session ranked by the bandit is recorded in it once its
+	 * intention is recognized. NULL disables the bias.
+	 * \ingroup Interaction
+	 */
+	void setQueryTypeBandit(QueryTypeBandit* bandit);
+
 	/** @} */
 
 
-	/**
-	 * \name Learning
-	 * @{
+	/**
+	 * \name Learning
+	 * @{
 	 */
 	
 	/**
 	 * \brief Performs a pure update of template compatibilities with a learning rate where applicable
-	 * using Bayesian Incremental Learning
+	 * using Bayesian Incremental Learning. Ends the session first (see endSession()).
+	 * With a template journal, the map is not rewritten, as the session is already journaled.
+	 * \ingroup Learning
+	 */
+	void writeTemplates();
+
+	/**
+	 * \brief Applies the template updates learned from the answers of the session to the
+	 * template map in one batch
+	 *
+	 * Answers only buffer their updates, so that the map is not written while the user
+	 * is being questioned. The updates are also appended to the template journal if
+	 * there is one. Called by writeTemplates() and reinitialize().
+	 * \ingroup Learning
+	 */
+	void endSession();
+
+	/**
+	 * \brief Records the template updates of every session in \c journal instead of
+	 * rewriting the template map, and loads the map through it, i.e. with the journaled
+	 * sessions replayed. The journal is owned by the caller so that it can be compacted
+	 * in the background across sessions. NULL returns to rewriting the map.
+	 * \ingroup Learning
+	 */
+	void setTemplateJournal(TemplateJournal* journal);
+
+	/**
+	 * \brief Lowers the compatibility of every <object, action> pair that the user rejects by
+	 * \c rate, so that the same wrong intention is not proposed first session after
+	 * session; 0 disables negative feedback
+	 *
+	 * Unlike the learning rate, which is added to the pair that was recognized, \c rate is
+	 * on the scale of the normalized template, whose states sum to 1: e.g. 0.05 lowers a
+	 * compatibility of 0.625 to about 0.6 once the template is normalized again. The
+	 * compatibility never drops below those of the other states of the template, so a rate
+	 * close to the compatibility itself resets the pair in a single rejection.
+	 * \ingroup Learning
+	 */
+	void setNegativeLearningRate(const double& rate);
+
+	/// Gets the rate at which rejected <object, action> pairs lose compatibility
+	double getNegativeLearningRate() const;
+
+	/**
+	 * \brief Multiplies the compatibility of every <object, action> factor by how likely
+	 * \c history predicts the pair to follow the intention recognized last. Recognized
+	 * intentions are recorded in \c history, which is owned by the caller so that it
+	 * spans sessions. NULL disables the sequential prior.
+	 * \ingroup Learning
+	 */
+	void setIntentionHistory(IntentionHistory* history);
+
+	/**
+	 * \brief Reset templates to default probabilities
 	 * \ingroup Learning
 	 */
-	void writeTemplates();
-
-	/**
-	 * \brief Reset templates to default probabilities
-	 * \ingroup Learning
-	 */
 	void resetTemplates();
 
+	/**
+	 * \brief Gets the template map, including the updates of the sessions that have ended
+	 * \ingroup Learning
+	 */
+	const ObjectActionMap& getObjectActionMap() const;
+
 	/**
 	 * \brief Updates template compatibilities based on observed information from the Object-Action Intention Network
 	 */
@@ -176,12 +445,18 @@ public:
 	 * \brief Return a copy of the constructed network.
 	 */
 	dai::FactorGraph getNetwork() const;
+
+	/**
+	 * \brief Gets the inference results of the current scene so that query generators
+	 * and selectors can share them instead of running inference again
+	 */
+	SceneInferencePtr getSceneInference() const;
 	
 
 private:
-	/**
-	 * \name Book Keeping 
-	 * @{
+	/**
+	 * \name Book Keeping 
+	 * @{
 	 */
 
 	/// Object-Action Compatibility Templates 
@@ -224,6 +499,14 @@ private:
 	/// \ingroup Book Keeping
 	ObjectFactorListMap objectActionFactors;
 
+	/// Map a factor index to the object and action nodes it connects
+	/// \ingroup Book Keeping
+	FactorEndpointList factorEndpoints;
+
+	/// The object instances of the scene that afford each action
+	/// \ingroup Book Keeping
+	SceneAffordances affordances;
+
 	/// Map an action's network node index to its template action index
 	/// \ingroup Book Keeping
 	ActionTemplateIndexMap actionTemplateIndex;
@@ -232,6 +515,14 @@ private:
 	/// \ingroup Book Keeping
 	ObjectTemplateIndexMap objectTemplateIndex;
 
+	/// Names of the objects and actions referred to by the queries
+	/// \ingroup Book Keeping
+	QueryNameTable queryNames;
+
+	/// Map a network node index to the identifier of its name in \c queryNames
+	/// \ingroup Book Keeping
+	std::vector<int> nodeNameIds;
+
 	/// Map an object-action pair to their template potentials
 	/// \ingroup Book Keeping
 	ObjectActionMap objectActionMap;
@@ -261,24 +552,116 @@ private:
 	/**
 	 * \name Network Administration
 	 */
-	/// The Object-Action Sensitive Network
-	dai::FactorGraph theNetwork;
+	/// The Object-Action Sensitive Network of the current scene and its beliefs
+	SceneInferencePtr scene;
 
-	/// The joint distribution of the object-action intention network represented by \c theNetwork
+	/// The joint distribution of the object-action intention network represented by \c scene
 	dai::Factor distribution;
 
-	/// The inference algorithm used for belief updating
-	dai::InfAlg* inferenceAlgo;
+	/// The current list of object-action queries for the network \c scene, ranked lazily,
+	/// along with the query being proposed to the user
+	QueryState state;
+
+	/// Computes the outcomes of both answers to the current query while the user answers
+	SpeculativeEvaluator speculation;
+
+	/// The queries presented together by the last call to selectQueries()
+	std::vector<Query> presentedQueries;
+
+	/// Seeded stream that breaks ties between queries of equal rank
+	TieBreakStream tieBreaks;
+
+	/// Planner of question policies, or NULL to propose the highest ranked query
+	QueryPlanner* planner;
+
+	/// Two-step lookahead selector, or NULL
+	QueryLookahead* lookahead;
+
+	/// Policy being followed for the current query set, or NULL
+	QueryPolicyPtr policy;
+
+	/// The planned queries, indexed by their query index
+	std::vector<Query> plannedQueries;
+
+	/// Policy deciding when to commit without asking, or NULL
+	AutoCommitPolicy* autoCommit;
+
+	/// The top full query of the current query set when it was generated
+	Query topIntention;
+
+	/// Confidence of the current scene, or a negative value once its outcome has been recorded
+	double sessionConfidence;
+
+	/// Indicates whether the recognizer committed to \c topIntention
+	bool committed;
+
+	/// Learns the query types to ask first, or NULL
+	QueryTypeBandit* typeBandit;
+
+	/// Context of the current scene in \c typeBandit
+	size_t banditContext;
+
+	/// Indicates whether the template map was provided rather than read from \c objectActionMapFileName
+	bool mapPreloaded;
+
+	/// Time allowed per turn in milliseconds, or 0 for no limit
+	double latencyBudget;
+
+	/// Tier that scored the current scene
+	ScoringTier scoringTier;
+
+	/// Cost model of the scenes of this recognizer, used when none is provided
+	SceneCostModel localCostModel;
+
+	/// Time at which the current turn started
+	boost::posix_time::ptime turnStart;
+
+	/// Template updates learned in the current session
+	TemplateUpdateBuffer templateUpdates;
+
+	/// Compatibility removed from a rejected <object, action> pair
+	double negativeLearningRate;
+
+	/// Recently recognized intentions, or NULL
+	IntentionHistory* history;
+
+	/// Journal of the template updates, or NULL
+	TemplateJournal* journal;
+
+	/// Indicates whether the current query set was ranked by \c typeBandit
+	bool banditWeighted;
+
+	/// Number of questions of each learned type asked since the query set was ranked by \c typeBandit
+	std::vector<size_t> banditAsked;
+
+	/// Number of questions asked since the query set was ranked by \c typeBandit
+	size_t banditInteractions;
 
-	/// The current list of object-action queries for the network \c theNetwork
-	std::vector<Query> queries;
+	/// Indicates whether the current query set refers to templates rather than to scene nodes
+	bool templateQuerySet;
 
-	/// The current query being proposed to the user
-	Query currentQuery;
+	/// Cost model shared with the recognizers of other scenes, or NULL
+	SceneCostModel* costModel;
 
-
-	/// Clear variables and data
-	void clean();
+
+	/// Orders in which the query set engine can propose the queries of a scene
+	enum QueryOrdering {
+		RANK_BY_SCORE,			///< Highest score first (see QueryComparator)
+		RANK_BY_TYPE,			///< Action, object then full queries, each by score (see CountsQueryComparator)
+		SHUFFLE					///< Random order
+	};
+
+	/// Clear variables and data
+	void clean();
+
+	/**
+	 * \brief Generates the query set of the scene in a single pass over its actions, objects
+	 * and <object, action> relations, ordered by \c ordering
+	 *
+	 * The queries are scored by the probabilities gathered when the network was
+	 * constructed, i.e. the marginals or the scene counts.
+	 */
+	void generateSceneQuerySet(const QueryOrdering& ordering);
 
 	/**
 	 * \brief Initializes all template compatibilities for all object categories
@@ -291,6 +674,22 @@ private:
 	 */
 	NetworkNode createGraphNode(const std::string& nodeName, const NodeType& type = dai::UNKNOWN, const size_t& indexInTemplate = 0);
 
+	/**
+	 * \brief Records the name identifier of the node with label \c label
+	 */
+	void setNodeNameId(const size_t& label, const int& nameId);
+
+	/**
+	 * \brief Records in the auto-commit policy whether the top intention was the user's
+	 */
+	void recordCommitOutcome(const bool& topWasCorrect);
+
+	/**
+	 * \brief Looks up or plans the question policy for \c querySet if a planner is set,
+	 * spending at most \c maxMillis on the search if it is positive
+	 */
+	void planQueries(const std::vector<Query>& querySet, const double& maxMillis = 0.);
+
 	/**
 	 * \brief Adds a newly created factor to the list of factors
 	 */
@@ -311,6 +710,30 @@ private:
 	 */
 	void getNumericalProbabilities();	
 
+	/**
+	 * \brief Gets the probabilities of object and action nodes and their factors from the
+	 * prior scores of the templates of the <object, action> factors, without inference
+	 */
+	void getPriorProbabilities();
+
+	/// Gets the cost model of the scenes, the one provided by the caller if there is one
+	SceneCostModel& getCostModel();
+
+	/**
+	 * \brief Runs inference on the network built from \c allFactors within the time left
+	 * of the latency budget and records the tier that scored the scene
+	 */
+	void inferWithinBudget();
+
+	/// Gets the milliseconds elapsed since the current turn started
+	double getTurnMillis() const;
+
+	/**
+	 * \brief Gets the template <object, action> pair of the full query \c q of the current query set
+	 * \return False if the query does not refer to a known object and action
+	 */
+	bool getTemplatePair(const Query& q, size_t& objTemplateIdx, size_t& actTemplateIdx) const;
+
 
 };
 
@@ -318,4 +741,4 @@ private:
 } /* oar */
 
 
-#endif /* OBJECT_ACTION_RECOGNIZER_H_ */
+#endif /* OBJECT_ACTION_RECOGNIZER_H_ */
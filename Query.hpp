@@ -38,108 +38,92 @@
 #define __QUERY_H__
 
 #include <cstdlib>
-#include <iostream>
-#include <string>
-#include <ctime>
-#include <dai/varset.h>
+#include <cmath>
 
 
 namespace oar {
 
 
+/// Resolution at which two query scores are considered equal when ranking
+const double SCORE_RESOLUTION = 0.00000001;
+
+
 /**
  * \brief Type of query
  *
- * A query can involve an action only, an object only or both
+ * A query can involve an action only, an object only or both, or it can ask whether
+ * the intended object is one of a group of objects
  */
 enum QueryType {
 	ACTION_QUERY,
 	OBJECT_QUERY,
 	FULL_QUERY,
+	GROUP_QUERY,
 	UNKNOWN
 };
 
 
 /**
  * \brief Represents a query that is used for intention prediction
+ *
+ * Queries are compact, trivially copyable records. The names of the object and the
+ * action are stored once in a QueryNameTable and referred to by their identifiers,
+ * and the human-readable question is only rendered (see QueryNameTable::question)
+ * when the query is actually presented to the user.
  */
 struct Query {
 	int index;					///< The index of this query
 	int objectIndex;			///< The object index in the graph
 	int actionIndex;			///< The action index in the graph
-	std::string objectName;		///< The name of this object, which is calculated
-	std::string actionName;		///< The name of this action, which is calculated
-	std::string question;		///< The human-readable question that would be posed to the user
+	int objectNameId;			///< Identifier of the object's name in the name table, or -1
+	int actionNameId;			///< Identifier of the action's name in the name table, or -1
+	int groupIndex;				///< Index of the group of objects in the group table, or -1
 	bool hasObject;				///< Indicates whether this query involves an object
 	bool hasAction;				///< Indicates whether this query involves an action
 	bool suggested;				///< Indicates whether this query was proposed to the user or not
 	bool accepted;				///< Indicates whether this query was accepted
 	double score;				///< Marginal probability of this query
+	double rankScore;			///< Score quantized to \c SCORE_RESOLUTION; used for ranking
+	unsigned int tieBreak;		///< Key that orders queries with equal rank scores
 	QueryType type;				///< Indicate the type of query
-	dai::VarSet nodes;			///< Variables involved in this query
 
 
 	/**
 	 * \brief Default Constructor
 	 */
-	Query() : index(-1), objectIndex(-1), actionIndex(-1),
-			objectName(), actionName(), question(),
+	Query() : index(-1), objectIndex(-1), actionIndex(-1), objectNameId(-1), actionNameId(-1), groupIndex(-1),
 			hasObject(false), hasAction(false), suggested(false), accepted(false),
-			score(0.0), type(UNKNOWN), nodes() {}
+			score(0.0), rankScore(0.0), tieBreak(0), type(UNKNOWN) {}
 
 
 	/**
 	 * \brief Constructs a full query. 
 	 */
-	Query (int idx, double s, int objIdx = -1, int actionIdx = -1, std::string objName = "", std::string actName = "") {
+	Query (int idx, double s, int objIdx = -1, int actionIdx = -1, int objNameId = -1, int actNameId = -1) {
 		index = idx;
 		score = s;
+		rankScore = quantizeScore(s);
+		tieBreak = 0;
+		type = UNKNOWN;
 		objectIndex = objIdx;
 		actionIndex = actionIdx;
-		objectName = objName;
-		actionName = actName;
+		objectNameId = objNameId;
+		actionNameId = actNameId;
+		groupIndex = -1;
 
 		(objectIndex != -1) ? hasObject = true : hasObject = false;
 		(actionIndex != -1) ? hasAction = true : hasAction = false;
 
 		suggested = false;
 		accepted = false;
-		
-		// Create the query based on the information provided
-		create();
-	}
-
-
-	/**
-	 * \brief Creates the human-readable query
-	 */
-	void create() {
-		std::string actionPhrase = actionName;
-
-		if (actionName.compare("Drink") == 0 || actionName.compare("Pour") == 0) {
-			actionPhrase = actionName + " from";
-		}
-
-		if (hasObject && hasAction) {
-			question = "Do you want to " + actionPhrase + " " + objectName + "?";		
-		} 
-		
-		if (hasObject && !hasAction) {
-			question = "Do you want to use the " + objectName + "?";		
-		} 
-		
-		if (!hasObject && hasAction) {
-			question = "Do you want to " + actionPhrase + " something?";
-		}
 	}
 
 
 	/**
-	 * \brief Prints the underlying query to the output stream
+	 * \brief Quantizes a score so that nearly equal scores rank as equal
 	 */
-	friend std::ostream& operator<<(std::ostream &os, const Query& q) {
-		os << "\n" << q.question << "\n";		
-		return os;
+	static double quantizeScore(const double& s) {
+		return floor(s / SCORE_RESOLUTION + 0.5);
 	}
 
 };
@@ -148,35 +132,30 @@ struct Query {
 
 /**
  * \brief Comparator class used for sorting Query vectors based on probabilities
+ *
+ * Queries are ordered by their rank scores. When these are equal, full queries come
+ * first and the remaining ties are broken by the precomputed \c tieBreak keys (see
+ * TieBreakStream) and finally by the query index, so that the ordering is a strict
+ * weak ordering and is reproducible.
  */
 struct QueryComparator {
 	bool operator() (const Query& lhs, const Query& rhs) const {
-		srand(static_cast<unsigned int>(time(NULL)));
-		bool shouldComeFirst = false;
-		double epsilon = 0.00000001;
-
-		if ((lhs.score - rhs.score) > epsilon){
-			shouldComeFirst = true;
-
-		} else if (fabs(lhs.score - rhs.score) < epsilon) {
-			if (lhs.type == FULL_QUERY) {
-				shouldComeFirst = true;
-
-			} else if ((lhs.type == ACTION_QUERY || lhs.type == OBJECT_QUERY) &&
-						(rhs.type == ACTION_QUERY || rhs.type == OBJECT_QUERY)) {
-				int coinFlip = rand() % 2;
-				
-				if (coinFlip == 0) {
-					shouldComeFirst = true;
-				} else if (coinFlip == 1) {
-					shouldComeFirst = false;
-				}
-			} else {
-				shouldComeFirst = false;
-			}
+		if (lhs.rankScore != rhs.rankScore) {
+			return (lhs.rankScore > rhs.rankScore);
 		}
 
-		return shouldComeFirst;
+		bool lhsIsFull = (lhs.type == FULL_QUERY);
+		bool rhsIsFull = (rhs.type == FULL_QUERY);
+
+		if (lhsIsFull != rhsIsFull) {
+			return lhsIsFull;
+		}
+
+		if (lhs.tieBreak != rhs.tieBreak) {
+			return (lhs.tieBreak < rhs.tieBreak);
+		}
+
+		return (lhs.index < rhs.index);
 	}
 };
 
@@ -186,37 +165,33 @@ struct QueryComparator {
  */
 struct CountsQueryComparator {
 	bool operator() (const Query& lhs, const Query& rhs) const {
-		bool shouldComeFirst = false;
-		double epsilon = 0.00000001;
-		if (lhs.type == rhs.type) {
-			if ((lhs.score - rhs.score) > epsilon) {
-				shouldComeFirst = true;
-			} else {
-				shouldComeFirst = false;
-			}
-		
-		} else if (lhs.type == ACTION_QUERY) {
-			shouldComeFirst = true;
-
-		} else if (lhs.type == OBJECT_QUERY) {
-			if (rhs.type == ACTION_QUERY) {
-				shouldComeFirst = false;
-
-			} else if (rhs.type == FULL_QUERY) {
-				shouldComeFirst = true;
-
-			}
-			
-		} else if (lhs.type == FULL_QUERY) {
-			if (rhs.type == ACTION_QUERY) {
-				shouldComeFirst = false;
-
-			} else if (rhs.type == OBJECT_QUERY) {
-				shouldComeFirst = false;
-			}			
-		}		
-
-		return shouldComeFirst;
+		if (lhs.type != rhs.type) {
+			return (typeRank(lhs.type) < typeRank(rhs.type));
+		}
+
+		if (lhs.rankScore != rhs.rankScore) {
+			return (lhs.rankScore > rhs.rankScore);
+		}
+
+		if (lhs.tieBreak != rhs.tieBreak) {
+			return (lhs.tieBreak < rhs.tieBreak);
+		}
+
+		return (lhs.index < rhs.index);
+	}
+
+	/// Position of a query type in the ordering
+	static int typeRank(const QueryType& type) {
+		switch (type) {
+		case ACTION_QUERY:
+			return 0;
+		case OBJECT_QUERY:
+			return 1;
+		case FULL_QUERY:
+			return 2;
+		default:
+			return 3;
+		}
 	}
 };
 
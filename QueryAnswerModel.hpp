@@ -0,0 +1,236 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file QueryAnswerModel.hpp
+ *	\brief Models how the answers of the user prune a query set
+ *	\author	Kester Duncan
+ */
+#ifndef __QUERY_ANSWER_MODEL_H__
+#define __QUERY_ANSWER_MODEL_H__
+
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <boost/dynamic_bitset.hpp>
+#include "Query.hpp"
+#include "QueryGroupTable.hpp"
+
+
+namespace oar {
+
+
+/// Smallest probability given to an intention, so that every intention stays reachable
+const double MIN_INTENTION_PROBABILITY = 1e-12;
+
+
+/// Set of the queries that are still in a query list, indexed by position in a QueryAnswerModel
+typedef boost::dynamic_bitset<> QueryStateSet;
+
+
+/**
+ * \brief The states that the two answers to a query lead to
+ */
+struct AnswerSplit {
+	double pYes;				///< Probability that the answer is "yes"
+	QueryStateSet yesState;		///< Queries left after a "yes"; empty for full queries, which end the interaction
+	QueryStateSet noState;		///< Queries left after a "no"
+};
+
+
+/**
+ * \brief Models how the answers of the user prune a query set
+ *
+ * A state is the set of queries left after a sequence of answers. The full queries
+ * of a state are its candidate intentions, one of which is the user's, weighted by
+ * their scores. The answers prune the state exactly as
+ * ObjectActionRecognizer::evaluate() prunes its query list.
+ */
+class QueryAnswerModel {
+public:
+	/**
+	 * \brief Builds the model of \c querySet; states refer to the queries by their position in it
+	 *
+	 * The groups of any group queries in \c querySet are looked up in \c groups.
+	 */
+	explicit QueryAnswerModel(const std::vector<Query>& querySet, const QueryGroupTable* groups = NULL) : queries(querySet) {
+		const size_t n = queries.size();
+		double total = 0.;
+
+		fullQueries.resize(n);
+		yesKeep.assign(n, QueryStateSet(n));
+		noRemove.assign(n, QueryStateSet(n));
+		probability.assign(n, 0.);
+
+		for (size_t i = 0; i < n; i++) {
+			if (queries[i].type == FULL_QUERY) {
+				fullQueries.set(i);
+				probability[i] = std::max(queries[i].score, MIN_INTENTION_PROBABILITY);
+				total += probability[i];
+			}
+		}
+
+		for (size_t i = 0; i < n; i++) {
+			probability[i] /= total;
+		}
+
+		for (size_t i = 0; i < n; i++) {
+			const Query& q = queries[i];
+
+			for (size_t j = 0; j < n; j++) {
+				const Query& other = queries[j];
+
+				if (q.type == ACTION_QUERY) {
+					yesKeep[i][j] = (other.hasObject && other.hasAction && other.actionIndex == q.actionIndex);
+					noRemove[i][j] = (other.actionIndex == q.actionIndex);
+
+				} else if (q.type == OBJECT_QUERY) {
+					yesKeep[i][j] = (other.hasObject && other.hasAction && other.objectIndex == q.objectIndex);
+					noRemove[i][j] = (other.objectIndex == q.objectIndex);
+
+				} else if (q.type == FULL_QUERY) {
+					noRemove[i][j] = (j == i)
+						|| (other.type == OBJECT_QUERY && other.objectIndex == q.objectIndex)
+						|| (other.type == ACTION_QUERY && other.actionIndex == q.actionIndex);
+
+				} else if (q.type == GROUP_QUERY && groups != NULL) {
+					bool inGroup = other.hasObject && groups->contains(q.groupIndex, other.objectIndex);
+
+					yesKeep[i][j] = (other.type == ACTION_QUERY) || inGroup;
+					noRemove[i][j] = (j == i) || inGroup;
+				}
+			}
+		}
+	}
+
+	/// Number of queries
+	size_t size() const {
+		return queries.size();
+	}
+
+	/// The query at position \c pos
+	const Query& query(const size_t& pos) const {
+		return queries[pos];
+	}
+
+	/// The state in which no query has been answered yet
+	QueryStateSet initialState() const {
+		QueryStateSet all (queries.size());
+		all.set();
+		return all;
+	}
+
+	/// Probability mass of the intentions left in \c state
+	double mass(const QueryStateSet& state) const {
+		QueryStateSet intentions = state & fullQueries;
+		double m = 0.;
+
+		for (size_t i = intentions.find_first(); i != QueryStateSet::npos; i = intentions.find_next(i)) {
+			m += probability[i];
+		}
+
+		return m;
+	}
+
+	/**
+	 * \brief Lower bound on the expected number of questions needed to recognize the
+	 * intention in \c state
+	 *
+	 * Every intention ends at its own "yes" to a full query, so the answer sequences
+	 * form a prefix-free binary code and cannot be shorter than the entropy on average.
+	 */
+	double lowerBound(const QueryStateSet& state) const {
+		QueryStateSet intentions = state & fullQueries;
+		double m = mass(state);
+		double h = 0.;
+
+		if (m <= 0.) {
+			return 0.;
+		}
+
+		for (size_t i = intentions.find_first(); i != QueryStateSet::npos; i = intentions.find_next(i)) {
+			double p = probability[i] / m;
+			h -= p * log(p);
+		}
+
+		return std::max(1., h / log(2.0));
+	}
+
+	/**
+	 * \brief Splits \c state (of mass \c stateMass) on the answer to the query at \c pos
+	 * \return False if asking the query makes no progress, i.e. its answer is already known
+	 */
+	bool split(const QueryStateSet& state, const double& stateMass, const size_t& pos, AnswerSplit& result) const {
+		const Query& q = queries[pos];
+
+		if (!state[pos]) {
+			return false;
+		}
+
+		if (q.type == FULL_QUERY) {
+			result.pYes = probability[pos] / stateMass;
+			result.yesState = QueryStateSet(queries.size());
+
+		} else if (q.type == ACTION_QUERY || q.type == OBJECT_QUERY || q.type == GROUP_QUERY) {
+			result.yesState = state & yesKeep[pos];
+			result.pYes = mass(result.yesState) / stateMass;
+
+			if (result.pYes <= 0. || result.pYes >= 1.) {
+				return false;
+			}
+		} else {
+			return false;
+		}
+
+		result.noState = state - noRemove[pos];
+		return true;
+	}
+
+	/// Indicates whether a "yes" to the query at \c pos recognizes the intention
+	bool endsInteraction(const size_t& pos) const {
+		return (queries[pos].type == FULL_QUERY);
+	}
+
+
+private:
+	std::vector<Query> queries;
+	std::vector<double> probability;
+	QueryStateSet fullQueries;
+	std::vector<QueryStateSet> yesKeep;
+	std::vector<QueryStateSet> noRemove;
+
+};
+
+
+} /* oar */
+
+#endif /* __QUERY_ANSWER_MODEL_H__ */
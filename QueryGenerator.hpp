@@ -13,65 +13,24 @@
 #include <cassert>
 #include <ctime>
 #include <exception>
+#include <algorithm>
+#include <dai/daialg.h>
 #include <dai/factorgraph.h>
 #include <dai/varset.h>
 
 #include "Query.hpp"
+#include "QueryRanking.hpp"
+#include "QueryNameTable.hpp"
 #include "OARTypes.h"
+#include "SceneInference.hpp"
 
 
 namespace oar {
 
-/// Represents a scoring type to associate node indices to marginal probabilities
-typedef std::pair<size_t, double> NodeProbabilityPair;
-
-
-/**
- * \brief Comparator class used for sorting Node Probability Pairs
- */
-struct ProbComp {
-	bool operator() (const NodeProbabilityPair& lhs, const NodeProbabilityPair& rhs) const {
-		double epsilon = 0.0000001;
-		return ((rhs.second - lhs.second) < epsilon);
-	}
-};
-
-
 /**
  * \brief Comparator class used for sorting Query vectors
  */
-struct QueryComp {
-	bool operator() (const Query& lhs, const Query& rhs) const {
-		srand(static_cast<unsigned int>(time(NULL)));
-		bool shouldComeFirst = false;
-		double epsilon = 0.00000001;
-
-		if ((lhs.score - rhs.score) > epsilon){
-			shouldComeFirst = true;
-
-		} else if (fabs(lhs.score - rhs.score) < epsilon) {
-			if (lhs.type == FULL_QUERY) {
-				shouldComeFirst = true;
-
-			} else if ((lhs.type == ACTION_QUERY || lhs.type == OBJECT_QUERY) &&
-						(rhs.type == ACTION_QUERY || rhs.type == OBJECT_QUERY)) {
-				int coinFlip = rand() % 1;
-				
-				if (coinFlip == 0) {
-					shouldComeFirst = true;
-
-				} else if (coinFlip == 1) {
-					shouldComeFirst = false;
-
-				}
-			} else {
-				shouldComeFirst = false;
-			}
-		}
-
-		return shouldComeFirst;
-	}
-};
+typedef QueryComparator QueryComp;
 
 
 /**
@@ -79,13 +38,19 @@ struct QueryComp {
  * factors of an Object-Action Intention Network (Markov Network)
  */
 struct QueryGenerator {
-	dai::FactorGraph* network;
+	/// Network and beliefs of the scene, shared with whoever ran the inference
+	SceneInferencePtr scene;
 	dai::Factor distribution;
-	dai::InfAlg* inferenceAlgo;
 	std::vector<NodeProbabilityPair> objects;
 	std::vector<NodeProbabilityPair> actions;
 	std::vector<NodeProbabilityPair> relations;
 	std::vector<Query> queries;
+
+	/// Seeded stream that breaks ties between queries of equal rank
+	TieBreakStream tieBreaks;
+
+	/// Names of the objects and actions referred to by the queries
+	QueryNameTable names;
 	
 	/// Stores the names of all objects in the scene
 	NameMap objectNames;
@@ -97,12 +62,16 @@ struct QueryGenerator {
 	NodePropertiesList allNodes;
 
 
-	QueryGenerator() : network(0), inferenceAlgo(0) {}
+	QueryGenerator() {}
 
 	QueryGenerator(dai::FactorGraph& net) {
 		init(net);
 	}
 
+	QueryGenerator(const SceneInferencePtr& sharedScene) {
+		init(sharedScene);
+	}
+
 	~QueryGenerator() {
 		cleanUp();
 	}
@@ -119,32 +88,41 @@ struct QueryGenerator {
 		this->allNodes = otherAllNodes;
 	}
 
-	/// Instantiate the generator
+	/// Instantiate the generator for a network that has not been inferred yet
 	void init (dai::FactorGraph& net) {
-		network = net.clone();
+		init(SceneInferencePtr(new SceneInference(net)));
+	}
 
-		dai::PropertySet infProps;
-		infProps.set("tol", 0.00001);
-		infProps.set("logdomain", true);
-		infProps.set("updates", std::string("SEQMAX"));
-		infProps.set("inference", std::string("MAXPROD"));
-		
-		inferenceAlgo = newInfAlg("BP", *network, infProps );
-		inferenceAlgo->init();
-		inferenceAlgo->run();		
-		getMarginalProbabilities();		
+	/// Instantiate the generator from the inference results of a scene, e.g. those of the recognizer
+	void init (const SceneInferencePtr& sharedScene) {
+		scene = sharedScene;
+		getMarginalProbabilities();
+	}
 
+	/**
+	 * \brief Gets the name of node \c label from \c allNodes, or from the network if the
+	 * node properties were not given
+	 */
+	std::string nodeName(const size_t& label) const {
+		if (label < allNodes.size()) {
+			return allNodes[label].name;
+		}
+		return scene->network().var(label).name();
 	}
 
-	/// Clean up
-	void cleanUp () {
-		if (network) {
-			delete network;
-		}	
+	/// Gets the name of node \c label from \c nameMap, or from the network if it is not in the map
+	std::string nodeName(const size_t& label, const NameMap& nameMap) const {
+		NameMap::const_iterator it = nameMap.find(label);
 
-		if (inferenceAlgo) {
-			delete inferenceAlgo;
+		if (it != nameMap.end()) {
+			return it->second;
 		}
+		return scene->network().var(label).name();
+	}
+
+	/// Clean up
+	void cleanUp () {
+		scene.reset();
 	}
 
 
@@ -152,8 +130,8 @@ struct QueryGenerator {
 	 * Gets the marginal probabilities of object and action nodes and their factors. 
 	 */
 	void getMarginalProbabilities() {
-		std::vector<dai::Var> nodes = network->vars();
-		std::vector<dai::Factor> factors = network->factors();
+		const dai::FactorGraph& network = scene->network();
+		const std::vector<dai::Var>& nodes = network.vars();
 
 		actions.clear();
 		objects.clear();
@@ -163,13 +141,13 @@ struct QueryGenerator {
 			if (nodes[i].type() == dai::ACTION) {
 				NodeProbabilityPair s;
 				s.first = i;
-				s.second = inferenceAlgo->belief(nodes[i])[1];
+				s.second = scene->nodeProbability(i);
 				actions.push_back(s);				
 				
 			} else if (nodes[i].type() == dai::OBJECT) {
 				NodeProbabilityPair s;
 				s.first = i;
-				s.second = inferenceAlgo->belief(nodes[i])[1];
+				s.second = scene->nodeProbability(i);
 				objects.push_back(s);
 				
 			}
@@ -178,22 +156,11 @@ struct QueryGenerator {
 		//std::sort(actions.begin(), actions.end(), ProbComp());
 		//std::sort(objects.begin(), objects.end(), ProbComp());		
 		
-		for (size_t k = 0; k < factors.size(); k++) {
-			std::vector<dai::Var> vars = factors[k].vars().elements();
-			bool relevant = false;
-
-			if (vars.size() == 2) {
-				if (vars[0].type() == dai::ACTION && vars[1].type() == dai::OBJECT) {
-					relevant = true;					
-				} else if (vars[1].type() == dai::ACTION && vars[0].type() == dai::OBJECT) {
-					relevant = true;	
-				}
-			}	
-								
-			if (relevant == true) {
+		for (size_t k = 0; k < network.nrFactors(); k++) {
+			if (scene->isRelation(k)) {
 				NodeProbabilityPair s;
 				s.first = k;
-				s.second = inferenceAlgo->belief(factors[k].vars())[3];
+				s.second = scene->relationProbability(k);
 				relations.push_back(s); 						
 			}			
 		}
@@ -207,8 +174,8 @@ struct QueryGenerator {
 	 */
 	// FIXME fix or eliminate this
 	void getJointProbabilities() {
-		std::vector<dai::Var> nodes = network->vars();
-		std::vector<dai::Factor> factors = network->factors();
+		const dai::FactorGraph& network = scene->network();
+		const std::vector<dai::Var>& nodes = network.vars();
 		dai::VarSet actionVariables;
 		dai::VarSet objectVariables;
 
@@ -247,7 +214,7 @@ struct QueryGenerator {
 				s.first = i;
 
 				try {
-					value = inferenceAlgo->belief(actionVariables)[linearState];
+					value = scene->belief(actionVariables)[linearState];
 				} catch (std::exception& e) {
 					std::cout << "Exception getting action marginals: \n";
 					std::cout << e.what();
@@ -277,7 +244,7 @@ struct QueryGenerator {
 				s.first = i;
 
 				try {
-					value = inferenceAlgo->belief(objectVariables)[linearState];
+					value = scene->belief(objectVariables)[linearState];
 				} catch (std::exception& e) {
 					std::cout << "Exception getting object marginals: \n";
 					std::cout << e.what();
@@ -289,22 +256,11 @@ struct QueryGenerator {
 			}
 		}	
 		
-		for (size_t k = 0; k < factors.size(); k++) {
-			std::vector<dai::Var> vars = factors[k].vars().elements();
-			bool relevant = false;
-
-			if (vars.size() == 2) {
-				if (vars[0].type() == dai::ACTION && vars[1].type() == dai::OBJECT) {
-					relevant = true;					
-				} else if (vars[1].type() == dai::ACTION && vars[0].type() == dai::OBJECT) {
-					relevant = true;	
-				}
-			}	
-								
-			if (relevant == true) {
+		for (size_t k = 0; k < network.nrFactors(); k++) {
+			if (scene->isRelation(k)) {
 				NodeProbabilityPair s;
 				s.first = k;
-				s.second = inferenceAlgo->belief(factors[k].vars())[3];
+				s.second = scene->relationProbability(k);
 				relations.push_back(s); 						
 			}			
 		}
@@ -318,12 +274,13 @@ struct QueryGenerator {
 	void generateQuerySet(bool sorted = true) {
 		int queryIdx = 0;
 		queries.clear();
+		names.clear();
 
 		//int objectIndex = 0; // Needed to access the 'objects' vector
 
 		// Add the action queries to the set
 		for (size_t i = 0; i < actions.size(); i++) {			
-			Query q (queryIdx, actions[i].second, -1, actions[i].first, "", allNodes[actions[i].first].name);
+			Query q (queryIdx, actions[i].second, -1, actions[i].first, -1, names.intern(nodeName(actions[i].first)));
 			q.type = ACTION_QUERY;
 			queries.push_back(q);
 			queryIdx++;
@@ -332,7 +289,7 @@ struct QueryGenerator {
 
 		// Add the object queries to the set
 		for (size_t j = 0; j < objects.size(); j++) {
-			Query q (queryIdx, objects[j].second, objects[j].first, -1, allNodes[objects[j].first].name, "");
+			Query q (queryIdx, objects[j].second, objects[j].first, -1, names.intern(nodeName(objects[j].first)), -1);
 			q.type = OBJECT_QUERY;
 			queries.push_back(q);				
 			//objectIndex++;
@@ -345,7 +302,7 @@ struct QueryGenerator {
 			std::string objName, actionName;
 			size_t objIdx, actionIdx;
 			size_t factorIdx = relations[i].first;
-			std::vector<dai::Var> nodes = network->factors()[factorIdx].vars().elements();
+			const std::vector<dai::Var>& nodes = scene->network().factor(factorIdx).vars().elements();
 
 			/*
 			 * All factors ONLY involve two variables, therefore in this case one is an action
@@ -355,17 +312,16 @@ struct QueryGenerator {
 			if (nodes[0].type() == dai::ACTION) {
 				actionIdx = nodes[0].label();
 				objIdx = nodes[1].label();
-				actionName = actionNames[actionIdx];
-				objName = objectNames[objIdx];
 			
 			} else if (nodes[0].type() == dai::OBJECT) {
 				objIdx = nodes[0].label();
 				actionIdx = nodes[1].label();
-				objName = objectNames[objIdx];
-				actionName = actionNames[actionIdx];				
 			}
 
-			Query q(queryIdx, relations[i].second, objIdx, actionIdx, objName, actionName);
+			objName = nodeName(objIdx, objectNames);
+			actionName = nodeName(actionIdx, actionNames);
+
+			Query q(queryIdx, relations[i].second, objIdx, actionIdx, names.intern(objName), names.intern(actionName));
 			q.type = FULL_QUERY;
 			queries.push_back(q);
 			queryIdx++;
@@ -375,6 +331,7 @@ struct QueryGenerator {
 
 		// Sort queries by score
 		if (sorted) {
+			tieBreaks.assignKeys(queries);
 			std::sort(queries.begin(), queries.end(), QueryComp());			
 		}
 
@@ -388,7 +345,7 @@ struct QueryGenerator {
 		os << "\nQuery Set [" << qs.queries.size() << " queries]\n\n";
 
 		for (size_t i = 0; i < qs.queries.size(); i++) {
-			os << qs.queries[i].index << ":\t " << qs.queries[i].question << " [ " << qs.queries[i].score << " ]" <<  std::endl;
+			os << qs.queries[i].index << ":\t " << qs.names.question(qs.queries[i]) << " [ " << qs.queries[i].score << " ]" <<  std::endl;
 		}		
 		return os;
 	}
@@ -0,0 +1,204 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file QueryGroupTable.hpp
+ *	\brief Stores the groups of objects asked about by group queries
+ *	\author	Kester Duncan
+ */
+#ifndef __QUERY_GROUP_TABLE_H__
+#define __QUERY_GROUP_TABLE_H__
+
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include "Query.hpp"
+#include "QueryNameTable.hpp"
+
+
+namespace oar {
+
+
+/**
+ * \brief Stores the groups of objects that group queries ("is it one of these?") refer to
+ *
+ * A group query refers to its group by \c Query::groupIndex, which keeps queries small.
+ * Groups are chosen to split the probability mass of the remaining intentions roughly
+ * in half, so that each answer rules out about half of the candidates.
+ */
+class QueryGroupTable {
+public:
+	/// Default constructor
+	QueryGroupTable() {}
+
+	/**
+	 * \brief Adds the group of objects \c objectIndices, named by \c objectNameIds
+	 * \return The index of the new group
+	 */
+	int add(const std::vector<int>& objectIndices, const std::vector<int>& objectNameIds) {
+		objects.push_back(objectIndices);
+		nameIds.push_back(objectNameIds);
+
+		std::sort(objects.back().begin(), objects.back().end());
+
+		return static_cast<int>(objects.size()) - 1;
+	}
+
+	/**
+	 * \brief Adds a group of objects that splits the mass of the full queries in \c querySet
+	 * roughly in half
+	 *
+	 * Objects are considered from most to least probable, and each is added to the group
+	 * if doing so brings the group's mass closer to half of the total.
+	 *
+	 * \param[out] groupMass The normalized mass of the intentions involving the group
+	 * \return The index of the new group, or -1 if there are fewer than two objects or
+	 * a single object already holds half of the mass, in which case asking about it
+	 * directly is better
+	 */
+	int addHalvingGroup(const std::vector<Query>& querySet, double& groupMass) {
+		std::map<int, double> objectMass;
+		std::map<int, int> objectNameId;
+		double total = 0.;
+
+		groupMass = 0.;
+
+		for (size_t i = 0; i < querySet.size(); i++) {
+			const Query& q = querySet[i];
+
+			if (q.type == FULL_QUERY) {
+				objectMass[q.objectIndex] += q.score;
+				objectNameId[q.objectIndex] = q.objectNameId;
+				total += q.score;
+			}
+		}
+
+		if (objectMass.size() < 2 || total <= 0.) {
+			return -1;
+		}
+
+		std::vector< std::pair<double, int> > byMass;
+		for (std::map<int, double>::const_iterator it = objectMass.begin(); it != objectMass.end(); ++it) {
+			byMass.push_back(std::make_pair(it->second / total, it->first));
+		}
+		std::sort(byMass.rbegin(), byMass.rend());
+
+		if (byMass[0].first >= 0.5) {
+			return -1;
+		}
+
+		std::vector<int> members;
+		std::vector<int> memberNames;
+
+		for (size_t i = 0; i < byMass.size(); i++) {
+			double withObject = groupMass + byMass[i].first;
+
+			if (fabs(withObject - 0.5) < fabs(groupMass - 0.5)) {
+				groupMass = withObject;
+				members.push_back(byMass[i].second);
+				memberNames.push_back(objectNameId[byMass[i].second]);
+			}
+		}
+
+		return add(members, memberNames);
+	}
+
+	/// Gets the objects of the group \c group
+	const std::vector<int>& members(const int& group) const {
+		return objects[group];
+	}
+
+	/// Indicates whether the object \c objectIndex belongs to the group \c group
+	bool contains(const int& group, const int& objectIndex) const {
+		return std::binary_search(objects[group].begin(), objects[group].end(), objectIndex);
+	}
+
+	/// Number of groups
+	size_t size() const {
+		return objects.size();
+	}
+
+	/// Removes all groups
+	void clear() {
+		objects.clear();
+		nameIds.clear();
+	}
+
+	/**
+	 * \brief Renders the human-readable question for the group query \c q into \c buffer,
+	 * without allocating
+	 */
+	void render(const Query& q, const QueryNameTable& names, QuestionBuffer& buffer) const {
+		const std::vector<int>& ids = nameIds[q.groupIndex];
+
+		buffer.clear();
+		buffer.append("Do you want to use one of these: ", 33);
+
+		for (size_t i = 0; i < ids.size(); i++) {
+			if (i + 1 == ids.size() && i > 0) {
+				buffer.append(" or ", 4);
+			} else if (i > 0) {
+				buffer.append(", ", 2);
+			}
+			buffer.append("the ", 4);
+			buffer.append(names.name(ids[i]));
+		}
+
+		buffer.append("?", 1);
+	}
+
+	/**
+	 * \brief Renders the human-readable question for the group query \c q
+	 */
+	std::string question(const Query& q, const QueryNameTable& names) const {
+		QuestionBuffer buffer;
+		render(q, names, buffer);
+
+		return std::string(buffer.c_str(), buffer.size());
+	}
+
+
+private:
+	/// Objects of each group, sorted by object index
+	std::vector< std::vector<int> > objects;
+
+	/// Name identifiers of the objects of each group, in order of decreasing mass
+	std::vector< std::vector<int> > nameIds;
+
+};
+
+
+} /* oar */
+
+#endif /* __QUERY_GROUP_TABLE_H__ */
@@ -0,0 +1,473 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file QueryHeap.hpp
+ *	\brief Lazily ranked set of queries backed by an indexed max-heap
+ *	\author	Kester Duncan
+ */
+#ifndef __QUERY_HEAP_H__
+#define __QUERY_HEAP_H__
+
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <boost/function.hpp>
+#include <boost/dynamic_bitset.hpp>
+#include "Query.hpp"
+#include "QueryGroupTable.hpp"
+#include "SceneAffordances.hpp"
+
+
+namespace oar {
+
+
+/**
+ * \brief Ordering used to rank queries. Returns true if \c lhs should be proposed before \c rhs
+ */
+typedef boost::function<bool (const Query&, const Query&)> QueryOrder;
+
+
+/**
+ * \brief Ranks a query set lazily
+ *
+ * The queries are stored once and the heap is built over their storage indices in
+ * linear time. Only the queries that are actually proposed to the user are ever
+ * ranked, so proposing k queries out of n costs O(n + k log n) instead of sorting
+ * the whole set. If no ordering is given, the queries are proposed in the order in
+ * which they were provided (e.g. a shuffled set).
+ */
+class QueryHeap {
+public:
+	/// Default constructor
+	QueryHeap() {}
+
+	/**
+	 * \brief Replaces the contents of the heap with \c querySet ranked by \c ord
+	 */
+	void assign(const std::vector<Query>& querySet, const QueryOrder& ord = QueryOrder()) {
+		items = querySet;
+		order = ord;
+		heap.resize(items.size());
+
+		for (size_t i = 0; i < heap.size(); i++) {
+			heap[i] = i;
+		}
+
+		heapify();
+	}
+
+	/// Removes all queries
+	void clear() {
+		items.clear();
+		heap.clear();
+	}
+
+	/// Indicates whether there are any queries left
+	bool empty() const {
+		return heap.empty();
+	}
+
+	/// Number of queries left
+	size_t size() const {
+		return heap.size();
+	}
+
+	/**
+	 * \brief Gets the highest ranked query
+	 * \remarks The heap must not be empty
+	 */
+	const Query& top() const {
+		return items[heap[0]];
+	}
+
+	/**
+	 * \brief Removes and returns the highest ranked query
+	 */
+	Query pop() {
+		Query best = items[heap[0]];
+
+		heap[0] = heap.back();
+		heap.pop_back();
+
+		if (!heap.empty()) {
+			siftDown(0);
+		}
+
+		return best;
+	}
+
+	/**
+	 * \brief Inserts a query into the ranking
+	 */
+	void push(const Query& q) {
+		items.push_back(q);
+		heap.push_back(items.size() - 1);
+		siftUp(heap.size() - 1);
+	}
+
+	/**
+	 * \brief Removes every query for which \c pred returns true
+	 * \return The number of queries removed
+	 */
+	template <typename Predicate>
+	size_t removeIf(Predicate pred) {
+		size_t kept = 0;
+
+		for (size_t i = 0; i < heap.size(); i++) {
+			if (!pred(items[heap[i]])) {
+				heap[kept] = heap[i];
+				kept++;
+			}
+		}
+
+		size_t removed = heap.size() - kept;
+
+		if (removed > 0) {
+			heap.resize(kept);
+			heapify();
+		}
+
+		return removed;
+	}
+
+	/**
+	 * \brief Gets the \c k highest ranked queries, best first, without removing them
+	 *
+	 * Only the part of the heap that can contain the top \c k is visited, which
+	 * costs O(k log k).
+	 */
+	std::vector<Query> peek(const size_t& k) const {
+		std::vector<Query> best;
+		std::vector<size_t> frontier;
+		FrontierOrder frontierOrder(this);
+
+		if (!heap.empty()) {
+			frontier.push_back(0);
+		}
+
+		while (best.size() < k && !frontier.empty()) {
+			std::pop_heap(frontier.begin(), frontier.end(), frontierOrder);
+			size_t pos = frontier.back();
+			frontier.pop_back();
+
+			best.push_back(items[heap[pos]]);
+
+			size_t left = 2 * pos + 1;
+			size_t right = left + 1;
+
+			if (left < heap.size()) {
+				frontier.push_back(left);
+				std::push_heap(frontier.begin(), frontier.end(), frontierOrder);
+			}
+			if (right < heap.size()) {
+				frontier.push_back(right);
+				std::push_heap(frontier.begin(), frontier.end(), frontierOrder);
+			}
+		}
+
+		return best;
+	}
+
+	/**
+	 * \brief Gets all of the remaining queries in ranked order
+	 */
+	std::vector<Query> ranked() const {
+		return peek(heap.size());
+	}
+
+	/**
+	 * \brief Gets all of the remaining queries in no particular order, without ranking them
+	 */
+	std::vector<Query> unordered() const {
+		std::vector<Query> remaining;
+		remaining.reserve(heap.size());
+
+		for (size_t i = 0; i < heap.size(); i++) {
+			remaining.push_back(items[heap[i]]);
+		}
+
+		return remaining;
+	}
+
+
+private:
+	/// Query storage; queries never move once stored
+	std::vector<Query> items;
+
+	/// Max-heap of indices into \c items
+	std::vector<size_t> heap;
+
+	/// Ordering of the queries
+	QueryOrder order;
+
+
+	/// Orders heap positions so that the best query is at the top of a std heap
+	struct FrontierOrder {
+		const QueryHeap* owner;
+
+		FrontierOrder(const QueryHeap* h) : owner(h) {}
+
+		bool operator() (const size_t& lhs, const size_t& rhs) const {
+			return owner->precedes(owner->heap[rhs], owner->heap[lhs]);
+		}
+	};
+
+	/// Determines whether the stored query at \c a ranks higher than the one at \c b
+	bool precedes(const size_t& a, const size_t& b) const {
+		if (order) {
+			return order(items[a], items[b]);
+		}
+		return (a < b);
+	}
+
+	/// Restores the heap property for the whole heap in linear time
+	void heapify() {
+		if (heap.size() > 1) {
+			for (size_t i = heap.size() / 2; i > 0; i--) {
+				siftDown(i - 1);
+			}
+		}
+	}
+
+	/// Moves the entry at \c pos up until its parent ranks higher
+	void siftUp(size_t pos) {
+		while (pos > 0) {
+			size_t parent = (pos - 1) / 2;
+
+			if (!precedes(heap[pos], heap[parent])) {
+				break;
+			}
+
+			std::swap(heap[pos], heap[parent]);
+			pos = parent;
+		}
+	}
+
+	/// Moves the entry at \c pos down until both children rank lower
+	void siftDown(size_t pos) {
+		const size_t n = heap.size();
+
+		while (true) {
+			size_t best = pos;
+			size_t left = 2 * pos + 1;
+			size_t right = left + 1;
+
+			if (left < n && precedes(heap[left], heap[best])) {
+				best = left;
+			}
+			if (right < n && precedes(heap[right], heap[best])) {
+				best = right;
+			}
+			if (best == pos) {
+				break;
+			}
+
+			std::swap(heap[pos], heap[best]);
+			pos = best;
+		}
+	}
+
+};
+
+
+
+/**
+ * \name Pruning predicates used with QueryHeap::removeIf
+ * @{
+ */
+
+/// Matches every query except the <object, action> queries involving the action \c actionIndex
+struct NotPairedWithAction {
+	int actionIndex;
+
+	NotPairedWithAction(const int& idx) : actionIndex(idx) {}
+
+	bool operator() (const Query& q) const {
+		return !(q.hasObject && q.hasAction && q.actionIndex == actionIndex);
+	}
+};
+
+
+/// Matches every query except the <object, action> queries involving the object \c objectIndex
+struct NotPairedWithObject {
+	int objectIndex;
+
+	NotPairedWithObject(const int& idx) : objectIndex(idx) {}
+
+	bool operator() (const Query& q) const {
+		return !(q.hasAction && q.hasObject && q.objectIndex == objectIndex);
+	}
+};
+
+
+/// Matches every query involving the action \c actionIndex
+struct InvolvesAction {
+	int actionIndex;
+
+	InvolvesAction(const int& idx) : actionIndex(idx) {}
+
+	bool operator() (const Query& q) const {
+		return (q.actionIndex == actionIndex);
+	}
+};
+
+
+/// Matches every query involving the object \c objectIndex
+struct InvolvesObject {
+	int objectIndex;
+
+	InvolvesObject(const int& idx) : objectIndex(idx) {}
+
+	bool operator() (const Query& q) const {
+		return (q.objectIndex == objectIndex);
+	}
+};
+
+
+/**
+ * Matches a rejected full query along with the object and action queries that are
+ * orphaned by its rejection
+ */
+struct OrphanedByRejection {
+	Query rejected;
+
+	OrphanedByRejection(const Query& q) : rejected(q) {}
+
+	bool operator() (const Query& q) const {
+		if (q.index == rejected.index) {
+			return true;
+		}
+		if (q.type == OBJECT_QUERY && q.objectIndex == rejected.objectIndex) {
+			return true;
+		}
+		if (q.type == ACTION_QUERY && q.actionIndex == rejected.actionIndex) {
+			return true;
+		}
+		return false;
+	}
+};
+
+
+/// Matches the group query of \c group and the queries involving objects outside of the group
+struct OutsideGroup {
+	const QueryGroupTable* groups;
+	int group;
+
+	OutsideGroup(const QueryGroupTable& table, const int& g) : groups(&table), group(g) {}
+
+	bool operator() (const Query& q) const {
+		if (q.type == GROUP_QUERY) {
+			return (q.groupIndex == group);
+		}
+		return (q.hasObject && !groups->contains(group, q.objectIndex));
+	}
+};
+
+
+/// Matches the group query of \c group and the queries involving objects in the group
+struct InvolvesGroup {
+	const QueryGroupTable* groups;
+	int group;
+
+	InvolvesGroup(const QueryGroupTable& table, const int& g) : groups(&table), group(g) {}
+
+	bool operator() (const Query& q) const {
+		if (q.type == GROUP_QUERY) {
+			return (q.groupIndex == group);
+		}
+		return (q.hasObject && groups->contains(group, q.objectIndex));
+	}
+};
+
+
+/// Matches every full query
+struct IsFullQuery {
+	bool operator() (const Query& q) const {
+		return (q.type == FULL_QUERY);
+	}
+};
+
+
+/// Matches every group query
+struct IsGroupQuery {
+	bool operator() (const Query& q) const {
+		return (q.type == GROUP_QUERY);
+	}
+};
+
+
+/// Matches the action queries whose action no object remaining in \c scene affords
+struct ActionNotAfforded {
+	const SceneAffordances* scene;
+
+	ActionNotAfforded(const SceneAffordances& s) : scene(&s) {}
+
+	bool operator() (const Query& q) const {
+		return (q.type == ACTION_QUERY && !(q.actionIndex >= 0 && scene->isAfforded(q.actionIndex)));
+	}
+};
+
+
+/**
+ * \brief Matches the action queries whose action is no longer part of any <object, action> query
+ *
+ * Used for query sets that are not backed by the affordances of a scene.
+ */
+struct ActionWithoutIntention {
+	/// Actions of the remaining <object, action> queries, one bit per action node
+	boost::dynamic_bitset<> liveActions;
+
+	ActionWithoutIntention(const std::vector<Query>& querySet) {
+		for (size_t i = 0; i < querySet.size(); i++) {
+			const Query& q = querySet[i];
+
+			if (q.type == FULL_QUERY && q.actionIndex >= 0) {
+				if (liveActions.size() <= static_cast<size_t>(q.actionIndex)) {
+					liveActions.resize(q.actionIndex + 1);
+				}
+				liveActions.set(q.actionIndex);
+			}
+		}
+	}
+
+	bool operator() (const Query& q) const {
+		return (q.type == ACTION_QUERY && !(q.actionIndex >= 0 && static_cast<size_t>(q.actionIndex) < liveActions.size()
+			&& liveActions.test(q.actionIndex)));
+	}
+};
+
+/** @} */
+
+
+} /* oar */
+
+#endif /* __QUERY_HEAP_H__ */
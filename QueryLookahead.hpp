@@ -0,0 +1,214 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file QueryLookahead.hpp
+ *	\brief Selects queries by their expected cost over the next two answers
+ *	\author	Kester Duncan
+ */
+#ifndef __QUERY_LOOKAHEAD_H__
+#define __QUERY_LOOKAHEAD_H__
+
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include "Query.hpp"
+#include "QueryAnswerModel.hpp"
+#include "ThreadPool.hpp"
+
+
+namespace oar {
+
+
+/**
+ * \brief Selects the query with the lowest expected cost over the next two answers
+ *
+ * For every candidate query both answers are simulated, the best follow-up question
+ * is found in each branch, and the states after the follow-up are costed with the
+ * entropy bound of QueryAnswerModel. This sits between the greedy ranking and the
+ * full plan of a QueryPlanner. The candidates are evaluated in parallel on a thread
+ * pool under a time budget per turn; if the budget runs out before every candidate
+ * has been evaluated, the highest ranked query is selected instead.
+ */
+class QueryLookahead {
+public:
+	/**
+	 * \brief Constructs a lookahead selector with a budget of \c budgetMillis per turn
+	 * running on \c numThreads threads (0 uses the hardware concurrency)
+	 */
+	explicit QueryLookahead(const double& budgetMillis = 200., const size_t& numThreads = 0) :
+		pool(numThreads), timeBudget(budgetMillis), lastTimedOut(false) {}
+
+	/// Sets the time budget per turn, in milliseconds
+	void setTimeBudget(const double& budgetMillis) {
+		timeBudget = budgetMillis;
+	}
+
+	/// Gets the time budget per turn, in milliseconds
+	double getTimeBudget() const {
+		return timeBudget;
+	}
+
+	/// Indicates whether the last selection ran out of time and fell back to the ranking
+	bool timedOut() const {
+		return lastTimedOut;
+	}
+
+	/**
+	 * \brief Selects a query from \c rankedQueries, which are ordered best first. The groups
+	 * of any group queries are looked up in \c groups.
+	 * \return The position of the selected query in \c rankedQueries
+	 */
+	size_t select(const std::vector<Query>& rankedQueries, const QueryGroupTable* groups = NULL) {
+		// Building the answer model is part of the turn, so the budget starts before it
+		const boost::posix_time::ptime deadline = boost::posix_time::microsec_clock::universal_time()
+			+ boost::posix_time::microseconds(static_cast<long>(timeBudget * 1000.));
+		const size_t n = rankedQueries.size();
+		QueryAnswerModel model (rankedQueries, groups);
+		QueryStateSet state = model.initialState();
+		std::vector<double> costs (n, HUGE_VAL);
+		std::vector<char> evaluated (n, 0);
+
+		lastTimedOut = false;
+
+		if (n == 0 || model.mass(state) <= 0.) {
+			return 0;
+		}
+
+		pool.parallelFor(n, LookaheadKernel(model, state, deadline, costs, evaluated));
+
+		size_t best = 0;
+		for (size_t i = 0; i < n; i++) {
+			if (!evaluated[i]) {
+				lastTimedOut = true;
+				return 0;
+			}
+			if (costs[i] < costs[best]) {
+				best = i;
+			}
+		}
+
+		return best;
+	}
+
+
+private:
+	/// Threads on which the candidates are evaluated
+	ThreadPool pool;
+
+	/// Time budget per turn, in milliseconds
+	double timeBudget;
+
+	/// Whether the last selection fell back to the ranking
+	bool lastTimedOut;
+
+
+	/**
+	 * \brief Computes the expected two-step cost of each candidate query
+	 */
+	struct LookaheadKernel {
+		const QueryAnswerModel* model;
+		const QueryStateSet* state;
+		boost::posix_time::ptime deadline;
+		std::vector<double>* costs;
+		std::vector<char>* evaluated;
+
+		LookaheadKernel(const QueryAnswerModel& m, const QueryStateSet& s, const boost::posix_time::ptime& d,
+				std::vector<double>& c, std::vector<char>& e) :
+			model(&m), state(&s), deadline(d), costs(&c), evaluated(&e) {}
+
+		void operator() (const size_t& i) const {
+			AnswerSplit split;
+			double yesCost = 0.;
+			double noCost = 0.;
+
+			if (expired()) {
+				return;
+			}
+
+			if (model->split(*state, model->mass(*state), i, split)) {
+				if (!model->endsInteraction(i) && !followUpCost(split.yesState, yesCost)) {
+					return;
+				}
+				if (!followUpCost(split.noState, noCost)) {
+					return;
+				}
+				(*costs)[i] = 1. + split.pYes * yesCost + (1. - split.pYes) * noCost;
+			}
+
+			(*evaluated)[i] = 1;
+		}
+
+		/**
+		 * \brief Expected cost of \c branch when the best follow-up question is asked next
+		 * \return False if the time budget ran out
+		 */
+		bool followUpCost(const QueryStateSet& branch, double& cost) const {
+			const double m = model->mass(branch);
+			AnswerSplit split;
+
+			cost = 0.;
+			if (m <= 0.) {
+				return true;
+			}
+
+			cost = HUGE_VAL;
+			for (size_t j = branch.find_first(); j != QueryStateSet::npos; j = branch.find_next(j)) {
+				if (expired()) {
+					return false;
+				}
+
+				if (model->split(branch, m, j, split)) {
+					double yesCost = model->endsInteraction(j) ? 0. : model->lowerBound(split.yesState);
+					double noCost = model->lowerBound(split.noState);
+					double c = 1. + split.pYes * yesCost + (1. - split.pYes) * noCost;
+
+					if (c < cost) {
+						cost = c;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		bool expired() const {
+			return (boost::posix_time::microsec_clock::universal_time() > deadline);
+		}
+	};
+
+};
+
+
+} /* oar */
+
+#endif /* __QUERY_LOOKAHEAD_H__ */
@@ -0,0 +1,260 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file QueryNameTable.hpp
+ *	\brief Shared table of interned query names and rendering of query questions
+ *	\author	Kester Duncan
+ */
+#ifndef __QUERY_NAME_TABLE_H__
+#define __QUERY_NAME_TABLE_H__
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <iostream>
+#include <vector>
+#include <map>
+#include "Query.hpp"
+
+
+namespace oar {
+
+
+/**
+ * \brief Fixed-capacity text buffer that questions are rendered into without allocating
+ *
+ * Text beyond the capacity is truncated.
+ */
+class QuestionBuffer {
+public:
+	/// Maximum number of characters, including the terminating null character
+	enum { CAPACITY = 512 };
+
+	QuestionBuffer() : length(0) {
+		text[0] = '\0';
+	}
+
+	/// Empties the buffer
+	void clear() {
+		length = 0;
+		text[0] = '\0';
+	}
+
+	/// Appends \c s
+	void append(const std::string& s) {
+		append(s.data(), s.size());
+	}
+
+	/// Appends the \c n characters at \c s
+	void append(const char* s, size_t n) {
+		if (n > CAPACITY - 1 - length) {
+			n = CAPACITY - 1 - length;
+		}
+
+		std::memcpy(text + length, s, n);
+		length += n;
+		text[length] = '\0';
+	}
+
+	/// Gets the null-terminated text
+	const char* c_str() const {
+		return text;
+	}
+
+	/// Number of characters in the buffer
+	size_t size() const {
+		return length;
+	}
+
+
+private:
+	char text[CAPACITY];
+	size_t length;
+
+};
+
+
+/// Writes the text of \c buffer to the output stream
+inline std::ostream& operator<<(std::ostream& os, const QuestionBuffer& buffer) {
+	return os.write(buffer.c_str(), buffer.size());
+}
+
+
+/**
+ * \brief Stores each object and action name used by a query set exactly once
+ *
+ * Queries refer to their names by identifier, which keeps them small and cheap to
+ * copy. When a name is added, the fixed parts of every question it can appear in are
+ * built once, so the human-readable question of a query is rendered by copying at
+ * most three precomputed pieces. All of the wording lives in buildTemplates().
+ */
+class QueryNameTable {
+public:
+	/// Default constructor
+	QueryNameTable() : noName(buildTemplates(std::string())) {}
+
+	/**
+	 * \brief Gets the identifier of \c name, adding it to the table if necessary
+	 */
+	int intern(const std::string& name) {
+		std::map<std::string, int>::const_iterator it = ids.find(name);
+
+		if (it != ids.end()) {
+			return it->second;
+		}
+
+		int id = static_cast<int>(names.size());
+		names.push_back(name);
+		ids[name] = id;
+		templates.push_back(buildTemplates(name));
+
+		return id;
+	}
+
+	/**
+	 * \brief Gets the name with the identifier \c id, or an empty string if there is none
+	 */
+	const std::string& name(const int& id) const {
+		static const std::string noName;
+
+		if (id < 0 || id >= static_cast<int>(names.size())) {
+			return noName;
+		}
+		return names[id];
+	}
+
+	/// Gets the name of the object involved in \c q
+	const std::string& objectName(const Query& q) const {
+		return name(q.objectNameId);
+	}
+
+	/// Gets the name of the action involved in \c q
+	const std::string& actionName(const Query& q) const {
+		return name(q.actionNameId);
+	}
+
+	/// Number of names stored
+	size_t size() const {
+		return names.size();
+	}
+
+	/// Removes all names
+	void clear() {
+		names.clear();
+		ids.clear();
+		templates.clear();
+	}
+
+	/**
+	 * \brief Renders the human-readable question that would be posed to the user for \c q
+	 * into \c buffer, without allocating
+	 */
+	void render(const Query& q, QuestionBuffer& buffer) const {
+		buffer.clear();
+
+		if (q.hasObject && q.hasAction) {
+			buffer.append(phrases(q.actionNameId).fullPrefix);
+			buffer.append(objectName(q));
+			buffer.append("?", 1);
+
+		} else if (q.hasObject) {
+			buffer.append(phrases(q.objectNameId).objectQuestion);
+
+		} else if (q.hasAction) {
+			buffer.append(phrases(q.actionNameId).actionQuestion);
+		}
+	}
+
+	/**
+	 * \brief Renders the human-readable question that would be posed to the user for \c q
+	 */
+	std::string question(const Query& q) const {
+		QuestionBuffer buffer;
+		render(q, buffer);
+
+		return std::string(buffer.c_str(), buffer.size());
+	}
+
+
+private:
+	/// Precomputed parts of the questions that a name appears in
+	struct QuestionTemplates {
+		std::string fullPrefix;			///< Full query up to the object, when the name is an action
+		std::string actionQuestion;		///< Whole action query, when the name is an action
+		std::string objectQuestion;		///< Whole object query, when the name is an object
+	};
+
+	/// Names indexed by identifier
+	std::vector<std::string> names;
+
+	/// Identifiers indexed by name
+	std::map<std::string, int> ids;
+
+	/// Question templates indexed by identifier
+	std::vector<QuestionTemplates> templates;
+
+	/// Question templates of an empty name
+	QuestionTemplates noName;
+
+
+	/// Gets the templates of the name with the identifier \c id, or those of an empty name
+	const QuestionTemplates& phrases(const int& id) const {
+		if (id < 0 || id >= static_cast<int>(templates.size())) {
+			return noName;
+		}
+		return templates[id];
+	}
+
+	/**
+	 * \brief Builds the parts of the questions in which \c name can appear
+	 */
+	static QuestionTemplates buildTemplates(const std::string& name) {
+		QuestionTemplates t;
+		std::string actionPhrase = name;
+
+		if (name.compare("Drink") == 0 || name.compare("Pour") == 0) {
+			actionPhrase = name + " from";
+		}
+
+		t.fullPrefix = "Do you want to " + actionPhrase + " ";
+		t.actionQuestion = "Do you want to " + actionPhrase + " something?";
+		t.objectQuestion = "Do you want to use the " + name + "?";
+
+		return t;
+	}
+
+};
+
+
+} /* oar */
+
+#endif /* __QUERY_NAME_TABLE_H__ */
@@ -0,0 +1,386 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file QueryPlanner.cpp
+ *	\brief Branch-and-bound search over the yes/no answer tree of a scene
+ *	\author	Kester Duncan
+ */
+#include <cmath>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include "QueryAnswerModel.hpp"
+#include "QueryPlanner.h"
+
+
+namespace oar {
+
+
+namespace {
+
+/// Resolution at which the posterior is quantized in scene signatures
+const double SIGNATURE_RESOLUTION = 0.001;
+
+
+/**
+ * \brief Answer tree search for a single scene
+ */
+class AnswerTreeSearch {
+public:
+	AnswerTreeSearch(const std::vector<Query>& querySet, const QueryGroupTable* groups, const size_t& budget,
+		const boost::posix_time::ptime& d) :
+		model(querySet, groups), maxExpansions(budget), deadline(d), expansions(0), exhausted(false),
+		timedOut(false) {}
+
+	/**
+	 * \brief Searches the answer tree and writes the resulting policy to \c policy
+	 */
+	void run(QueryPolicy& policy) {
+		QueryStateSet all = model.initialState();
+
+		policy.nodes.clear();
+
+		if (model.mass(all) > 0.) {
+			solve(all);
+			buildPolicy(all, policy);
+		}
+
+		policy.optimal = !exhausted;
+	}
+
+	/// True if the search stopped at the deadline rather than at its node budget
+	bool stoppedAtDeadline() const {
+		return timedOut;
+	}
+
+
+private:
+	/// Best known question for a state
+	struct Decision {
+		size_t query;
+		double cost;
+	};
+
+	/// A question that can be asked in a state, with the states its answers lead to
+	struct Candidate {
+		size_t query;
+		double bound;
+		AnswerSplit split;
+
+		bool operator< (const Candidate& other) const {
+			if (bound != other.bound) {
+				return (bound < other.bound);
+			}
+			return (query < other.query);
+		}
+	};
+
+	QueryAnswerModel model;
+	std::map<QueryStateSet, Decision> memo;
+	size_t maxExpansions;
+	boost::posix_time::ptime deadline;
+	size_t expansions;
+	bool exhausted;
+	bool timedOut;
+
+
+	/// True once the deadline, if any, has passed
+	bool pastDeadline() {
+		if (!timedOut && !deadline.is_not_a_date_time()) {
+			timedOut = (boost::posix_time::microsec_clock::universal_time() >= deadline);
+		}
+		return timedOut;
+	}
+
+
+	/// Lists the questions that can make progress in \c state
+	std::vector<Candidate> candidates(const QueryStateSet& state) const {
+		std::vector<Candidate> result;
+		const double m = model.mass(state);
+
+		for (size_t i = state.find_first(); i != QueryStateSet::npos; i = state.find_next(i)) {
+			Candidate c;
+			c.query = i;
+
+			if (model.split(state, m, i, c.split)) {
+				c.bound = questionCost(c, model.lowerBound(c.split.yesState), model.lowerBound(c.split.noState));
+				result.push_back(c);
+			}
+		}
+
+		return result;
+	}
+
+	/// Expected cost of asking \c c given the costs of the states its answers lead to
+	double questionCost(const Candidate& c, const double& yesCost, const double& noCost) const {
+		return 1. + c.split.pYes * yesCost + (1. - c.split.pYes) * noCost;
+	}
+
+	/// Solves the subtree of the state an answer leads to, if that answer can occur
+	double solveBranch(const QueryStateSet& state, const double& p, const bool& greedy) {
+		if (p <= 0. || model.mass(state) <= 0.) {
+			return 0.;
+		}
+		return (greedy ? solveGreedily(state) : solve(state));
+	}
+
+	/// Solves both branches of \c c and returns its expected cost
+	double solveCandidate(const Candidate& c, const bool& greedy) {
+		double yesCost = model.endsInteraction(c.query) ? 0. : solveBranch(c.split.yesState, c.split.pYes, greedy);
+		double noCost = solveBranch(c.split.noState, 1. - c.split.pYes, greedy);
+
+		return questionCost(c, yesCost, noCost);
+	}
+
+	/**
+	 * \brief Minimum expected number of questions needed in \c state
+	 *
+	 * Candidates are tried in increasing order of their lower bound, so the search
+	 * stops as soon as no remaining candidate can beat the best question found.
+	 */
+	double solve(const QueryStateSet& state) {
+		std::map<QueryStateSet, Decision>::const_iterator it = memo.find(state);
+		if (it != memo.end()) {
+			return it->second.cost;
+		}
+
+		if (expansions >= maxExpansions || pastDeadline()) {
+			exhausted = true;
+			return solveGreedily(state);
+		}
+		expansions++;
+
+		std::vector<Candidate> options = candidates(state);
+		std::sort(options.begin(), options.end());
+
+		Decision best;
+		best.query = options.front().query;
+		best.cost = HUGE_VAL;
+
+		for (size_t i = 0; i < options.size(); i++) {
+			if (options[i].bound >= best.cost) {
+				break;
+			}
+
+			double cost = solveCandidate(options[i], false);
+
+			if (cost < best.cost) {
+				best.query = options[i].query;
+				best.cost = cost;
+			}
+		}
+
+		memo[state] = best;
+		return best.cost;
+	}
+
+	/**
+	 * \brief Expected number of questions needed in \c state when always asking the
+	 * question with the highest information gain
+	 */
+	double solveGreedily(const QueryStateSet& state) {
+		std::map<QueryStateSet, Decision>::const_iterator it = memo.find(state);
+		if (it != memo.end()) {
+			return it->second.cost;
+		}
+
+		std::vector<Candidate> options = candidates(state);
+		size_t chosen = 0;
+		double bestGain = -1.;
+
+		for (size_t i = 0; i < options.size(); i++) {
+			const double p = options[i].split.pYes;
+			double gain = 0.;
+
+			if (p > 0. && p < 1.) {
+				gain = -(p * log(p) + (1. - p) * log(1. - p));
+			}
+
+			if (gain > bestGain || (gain == bestGain && p > options[chosen].split.pYes)) {
+				chosen = i;
+				bestGain = gain;
+			}
+		}
+
+		Decision d;
+		d.query = options[chosen].query;
+		d.cost = solveCandidate(options[chosen], true);
+
+		memo[state] = d;
+		return d.cost;
+	}
+
+	/// Writes the decisions reachable from \c state into \c policy and returns the step created
+	int buildPolicy(const QueryStateSet& state, QueryPolicy& policy) {
+		const Decision d = memo[state];
+		const int step = static_cast<int>(policy.nodes.size());
+		AnswerSplit split;
+
+		policy.nodes.push_back(PolicyNode(model.query(d.query).index, d.cost));
+		model.split(state, model.mass(state), d.query, split);
+
+		if (!model.endsInteraction(d.query) && model.mass(split.yesState) > 0.) {
+			int yes = buildPolicy(split.yesState, policy);
+			policy.nodes[step].yes = yes;
+		}
+
+		if (model.mass(split.noState) > 0.) {
+			int no = buildPolicy(split.noState, policy);
+			policy.nodes[step].no = no;
+		}
+
+		return step;
+	}
+};
+
+
+/// Orders queries by their index in the query set
+bool precedesInQuerySet(const Query& lhs, const Query& rhs) {
+	return (lhs.index < rhs.index);
+}
+
+} /* namespace */
+
+
+
+QueryPlanner::QueryPlanner(const size_t& maxExpansions, const size_t& maxCacheSize) :
+	maxExpansions(maxExpansions), maxCacheSize(maxCacheSize) {
+
+}
+
+
+QueryPolicyPtr QueryPlanner::plan(const std::vector<Query>& querySet, const QueryNameTable& names,
+		const QueryGroupTable* groups, const double& maxMillis) {
+
+	const std::string signature = sceneSignature(querySet, names, groups);
+	std::map<std::string, CacheEntry>::iterator it = cache.find(signature);
+
+	if (it != cache.end()) {
+		usage.splice(usage.begin(), usage, it->second.usage);
+		return it->second.policy;
+	}
+
+	std::vector<Query> ordered (querySet);
+	std::sort(ordered.begin(), ordered.end(), precedesInQuerySet);
+
+	boost::posix_time::ptime deadline;
+
+	if (maxMillis > 0.) {
+		deadline = boost::posix_time::microsec_clock::universal_time()
+			+ boost::posix_time::microseconds(static_cast<long>(maxMillis * 1000.));
+	}
+
+	boost::shared_ptr<QueryPolicy> policy (new QueryPolicy());
+	AnswerTreeSearch search (ordered, groups, maxExpansions, deadline);
+	search.run(*policy);
+
+	if (maxCacheSize > 0 && !search.stoppedAtDeadline()) {
+		CacheEntry& entry = cache[signature];
+		entry.policy = policy;
+		entry.usage = usage.insert(usage.begin(), signature);
+		evict();
+	}
+
+	return policy;
+}
+
+
+std::string QueryPlanner::sceneSignature(const std::vector<Query>& querySet, const QueryNameTable& names,
+		const QueryGroupTable* groups) {
+
+	std::vector<Query> ordered (querySet);
+	std::ostringstream signature;
+	double total = 0.;
+
+	std::sort(ordered.begin(), ordered.end(), precedesInQuerySet);
+
+	for (size_t i = 0; i < ordered.size(); i++) {
+		if (ordered[i].type == FULL_QUERY) {
+			total += ordered[i].score;
+		}
+	}
+
+	for (size_t i = 0; i < ordered.size(); i++) {
+		const Query& q = ordered[i];
+
+		signature << q.index << ':' << q.type << ':' << names.objectName(q) << ':' << names.actionName(q);
+
+		if (q.type == FULL_QUERY && total > 0.) {
+			signature << ':' << static_cast<long>(floor(q.score / total / SIGNATURE_RESOLUTION + 0.5));
+		}
+
+		if (q.type == GROUP_QUERY && groups != NULL) {
+			const std::vector<int>& members = groups->members(q.groupIndex);
+
+			for (size_t j = 0; j < members.size(); j++) {
+				signature << ':' << members[j];
+			}
+		}
+		signature << ';';
+	}
+
+	return signature.str();
+}
+
+
+size_t QueryPlanner::getCacheSize() const {
+	return cache.size();
+}
+
+
+void QueryPlanner::clearCache() {
+	cache.clear();
+	usage.clear();
+}
+
+
+void QueryPlanner::setMaxCacheSize(const size_t& maxCacheSize) {
+	this->maxCacheSize = maxCacheSize;
+	evict();
+}
+
+
+void QueryPlanner::evict() {
+	while (cache.size() > maxCacheSize) {
+		cache.erase(usage.back());
+		usage.pop_back();
+	}
+}
+
+
+void QueryPlanner::setMaxExpansions(const size_t& maxExpansions) {
+	this->maxExpansions = maxExpansions;
+}
+
+
+} /* oar */
@@ -0,0 +1,171 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file QueryPlanner.h
+ *	\brief Plans question policies that minimize the expected number of interactions
+ *	\author	Kester Duncan
+ */
+#ifndef QUERY_PLANNER_H_
+#define QUERY_PLANNER_H_
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <boost/shared_ptr.hpp>
+#include "Query.hpp"
+#include "QueryNameTable.hpp"
+#include "QueryGroupTable.hpp"
+
+
+namespace oar {
+
+
+/**
+ * \brief A step of a question policy
+ */
+struct PolicyNode {
+	int queryIndex;			///< Index (Query::index) of the query to ask
+	int yes;				///< Step to take after a "yes", or -1 if the intention has been recognized
+	int no;					///< Step to take after a "no", or -1 if no intention is left
+	double expectedCost;	///< Expected number of questions still to be asked from this step on
+
+	PolicyNode(const int& q = -1, const double& cost = 0.) : queryIndex(q), yes(-1), no(-1), expectedCost(cost) {}
+};
+
+
+/**
+ * \brief Decision tree over the yes/no answers of the user. The root is the first node.
+ */
+struct QueryPolicy {
+	std::vector<PolicyNode> nodes;
+
+	/// True if the search finished within its budget, i.e. the policy is optimal
+	bool optimal;
+
+	QueryPolicy() : optimal(false) {}
+
+	/// Expected number of interactions needed to recognize the intention
+	double expectedInteractions() const {
+		return (nodes.empty() ? 0. : nodes[0].expectedCost);
+	}
+};
+
+
+/// A planned policy, which stays valid while it is held even if the planner evicts it
+typedef boost::shared_ptr<const QueryPolicy> QueryPolicyPtr;
+
+
+/**
+ * \brief Computes question policies that minimize the expected number of interactions
+ *
+ * A scene is given by its query set: the scores of the full queries form the posterior
+ * over the <object, action> intentions, and the answers prune the set exactly as
+ * ObjectActionRecognizer::evaluate() does. The planner searches the answer tree with
+ * branch-and-bound, using the entropy of the remaining intentions as an admissible
+ * bound, and falls back to information-gain questioning for the subtrees it cannot
+ * afford to search within its node budget or before its deadline.
+ *
+ * Policies are cached by scene signature (the queries, their names and the quantized
+ * posterior), so a planner that outlives the recognizers plans each scene only once.
+ * The cache holds a bounded number of policies; the least recently used one is evicted
+ * to make room for a new scene. Policies cut short by the deadline are not cached, so
+ * the scene is planned again when there is more time.
+ */
+class QueryPlanner {
+public:
+	/**
+	 * \brief Constructs a planner that expands at most \c maxExpansions answer states per scene
+	 * and caches the policies of at most \c maxCacheSize scenes
+	 */
+	QueryPlanner(const size_t& maxExpansions = 5000, const size_t& maxCacheSize = 256);
+
+	/**
+	 * \brief Gets the policy for the scene given by \c querySet, planning it if it is not cached
+	 *
+	 * The groups of any group queries in \c querySet are looked up in \c groups. If
+	 * \c maxMillis is positive, the search stops expanding answer states after that many
+	 * milliseconds and questions the rest of the tree by information gain.
+	 */
+	QueryPolicyPtr plan(const std::vector<Query>& querySet, const QueryNameTable& names,
+		const QueryGroupTable* groups = NULL, const double& maxMillis = 0.);
+
+	/// Computes the key under which the policy of a scene is cached
+	static std::string sceneSignature(const std::vector<Query>& querySet, const QueryNameTable& names,
+		const QueryGroupTable* groups = NULL);
+
+	/// Number of cached policies
+	size_t getCacheSize() const;
+
+	/// Removes all cached policies
+	void clearCache();
+
+	/// Sets the maximum number of answer states expanded per scene
+	void setMaxExpansions(const size_t& maxExpansions);
+
+	/// Sets the maximum number of cached policies, evicting the least recently used ones beyond it
+	void setMaxCacheSize(const size_t& maxCacheSize);
+
+
+private:
+	/// Scene signatures of the cached policies, most recently used first
+	typedef std::list<std::string> UsageList;
+
+	/// A cached policy and the position of its scene in the usage list
+	struct CacheEntry {
+		QueryPolicyPtr policy;
+		UsageList::iterator usage;
+	};
+
+	/// Policies of the scenes planned so far, keyed by scene signature
+	std::map<std::string, CacheEntry> cache;
+
+	/// Scene signatures of \c cache, most recently used first
+	UsageList usage;
+
+	/// Node budget of the search
+	size_t maxExpansions;
+
+	/// Maximum number of cached policies
+	size_t maxCacheSize;
+
+
+	/// Evicts the least recently used policies until at most \c maxCacheSize remain
+	void evict();
+
+};
+
+
+} /* oar */
+
+#endif /* QUERY_PLANNER_H_ */
@@ -0,0 +1,118 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file QueryRanking.hpp
+ *	\brief Seeded tie-break stream used for reproducible query ranking
+ *	\author	Kester Duncan
+ */
+#ifndef __QUERY_RANKING_H__
+#define __QUERY_RANKING_H__
+
+#include <cstdlib>
+#include <cstddef>
+#include <vector>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include "Query.hpp"
+
+
+namespace oar {
+
+
+/**
+ * \brief Per-session random stream used to break ties between queries
+ *
+ * Every query receives its tie-break key once, before ranking, so that the query
+ * comparators are pure key comparisons. A session can be reproduced exactly by
+ * recording the seed and reseeding the stream with it.
+ */
+class TieBreakStream {
+public:
+	/// Constructs a stream seeded with \c seedValue
+	explicit TieBreakStream(const unsigned int& seedValue = 0) : engine(seedValue), currentSeed(seedValue) {}
+
+	/// Restarts the stream from \c seedValue
+	void reseed(const unsigned int& seedValue) {
+		currentSeed = seedValue;
+		engine.seed(seedValue);
+	}
+
+	/// Gets the seed the stream was last started from
+	unsigned int seed() const {
+		return currentSeed;
+	}
+
+	/// Draws the next tie-break key
+	unsigned int next() {
+		return static_cast<unsigned int>(engine());
+	}
+
+	/**
+	 * \brief Computes the ranking keys of every query in \c querySet
+	 */
+	void assignKeys(std::vector<Query>& querySet) {
+		for (size_t i = 0; i < querySet.size(); i++) {
+			querySet[i].rankScore = Query::quantizeScore(querySet[i].score);
+			querySet[i].tieBreak = next();
+		}
+	}
+
+	/**
+	 * \brief Ranks every query in \c querySet by \c rankValues instead of its score
+	 */
+	void assignKeys(std::vector<Query>& querySet, const std::vector<double>& rankValues) {
+		for (size_t i = 0; i < querySet.size(); i++) {
+			querySet[i].rankScore = Query::quantizeScore(rankValues[i]);
+			querySet[i].tieBreak = next();
+		}
+	}
+
+	/// Draws a number in [0, n); allows the stream to be used with std::random_shuffle
+	std::ptrdiff_t operator() (std::ptrdiff_t n) {
+		boost::random::uniform_int_distribution<std::ptrdiff_t> dist(0, n - 1);
+		return dist(engine);
+	}
+
+
+private:
+	/// Random number engine
+	boost::random::mt19937 engine;
+
+	/// Seed the engine was last started from
+	unsigned int currentSeed;
+
+};
+
+
+} /* oar */
+
+#endif /* __QUERY_RANKING_H__ */
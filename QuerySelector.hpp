@@ -10,9 +10,11 @@
 #define __HIPQUERYSELECTOR_H__
 
 #include "OARTypes.h"
-#include "NetworkUpdater.hpp"
 #include "Query.hpp"
 #include "QueryGenerator.hpp"
+#include "QueryHeap.hpp"
+#include "InformationGain.hpp"
+#include "ThreadPool.hpp"
 
 
 namespace oar {
@@ -23,27 +25,48 @@ namespace oar {
  *	involved in the query.
  */
 struct QuerySelector {
-	dai::FactorGraph network;
+	/// Network and beliefs of the scene, shared with the generator
+	SceneInferencePtr scene;
 	QueryGenerator generator;
 	bool useMutualInfo;
 	size_t currentIdx;
 	Query currentQuery;
 
+	/// Posterior over the intentions that are still possible
+	IntentionPosterior posterior;
 
-	QuerySelector(dai::FactorGraph& net, bool useMI = true) : network(net), useMutualInfo(useMI), currentIdx(0) {
-		generator.init(network);		
+	/// Workers used to score the candidate queries
+	ThreadPool pool;
+
+	/// The query set of the scene as generated, restored when the selection is reset
+	std::vector<Query> initialQueries;
+
+	/// Indicates whether \c initialQueries holds the query set of the scene
+	bool generated;
+
+
+	/**
+	 * The query set is generated on the first selection, so that the names of the nodes
+	 * can be given to the generator after construction
+	 */
+	QuerySelector(dai::FactorGraph& net, bool useMI = true) : scene(new SceneInference(net)), useMutualInfo(useMI), currentIdx(0),
+		generated(false) {
+		generator.init(scene);		
+	}
+
+	/// Selects queries for a scene that has already been inferred, e.g. by the recognizer
+	QuerySelector(const SceneInferencePtr& sharedScene, bool useMI = true) : scene(sharedScene), useMutualInfo(useMI), currentIdx(0),
+		generated(false) {
+		generator.init(scene);		
 	}
 
 	void select(bool reset = false) {
 		/*
-		 * By regenerating the query set, we run the risk of having the same query being 
-		 * asked over and over again in an infinite loop
+		 * By restoring the query set, we run the risk of having the same query being 
+		 * asked over and over again in an infinite loop. The scene is not inferred
+		 * again; the queries it generated are simply restored.
 		 */
-		if (reset) {
-			generator.cleanUp();
-			generator.init(network);
-			generator.generateQuerySet();
-		}
+		prepareQueries(reset);
 
 		if (!useMutualInfo) {
 			/*
@@ -57,27 +80,14 @@ struct QuerySelector {
 			/*
 			 * For mutual information-based queries, the suggested query is the
 			 * one that has the maximum mutual information which would be at the
-			 * top if the list is sorted accordingly
+			 * top if the list is sorted accordingly. The posterior comes from the
+			 * beliefs of the remaining full queries, so no inference is run here.
 			 */
-			std::map<size_t, size_t> observedVars;
+			posterior.assign(generator.queries);
 
-			for (size_t i = 0; i < generator.queries.size(); i++) {
-				Query q = generator.queries[i];
-				
-				if (q.hasAction) {
-					observedVars[q.actionIndex] = 1;
-				}
-
-				if (q.hasObject) {
-					observedVars[q.objectIndex] = 1;
-				}
-				double infoGain = 0.0;
-				
-				infoGain = NetworkUpdater::calculateInfoGain(*generator.network, observedVars);
-				generator.queries[i].score = infoGain;
-
-			}
+			std::vector<double> infoGains = computeInformationGains(posterior, generator.queries, pool);
 
+			generator.tieBreaks.assignKeys(generator.queries, infoGains);
 			std::sort(generator.queries.begin(), generator.queries.end(), QueryComp());
 			currentIdx = 0;
 			currentQuery = generator.queries[currentIdx];
@@ -88,8 +98,8 @@ struct QuerySelector {
 
 	/// Randomly select a query from the query set
 	void randomlySelect(bool reset = false) {
-		srand(static_cast<unsigned int>(time(NULL)));
-		currentIdx = rand() % generator.queries.size();	
+		prepareQueries(reset);
+		currentIdx = generator.tieBreaks(generator.queries.size());	
 
 		if (currentIdx >= 0) {
 			currentQuery = generator.queries[currentIdx];
@@ -101,9 +111,19 @@ struct QuerySelector {
 
 
 	/// Evaluate the choice that the user makes in order to determine the suggest the next query
-	bool evaluateChoice(bool answer, ObjectActionPair& observedVars = ObjectActionPair()) {
+	bool evaluateChoice(bool answer) {
+		ObjectActionPair observedVars;
+		return evaluateChoice(answer, observedVars);
+	}
+
+	/**
+	 * \brief Evaluate the choice that the user makes and report the observed object and action
+	 *
+	 * The remaining queries are pruned in place, so an answer costs a single pass over
+	 * them and the network of the scene is neither copied nor modified.
+	 */
+	bool evaluateChoice(bool answer, ObjectActionPair& observedVars) {
 		bool selectionComplete = false;
-		//std::map<size_t, size_t> observedVars;
 				
 		if (answer == true) {								
 			if (currentQuery.type == FULL_QUERY) {
@@ -121,8 +141,6 @@ struct QuerySelector {
 				}				
 								
 				selectionComplete = true;
-				//NetworkUpdater::observe(*generator.network, observedVars);
-				//NetworkUpdater::updateFactorGraph(*generator.network, observedVars);
 
 			} else if (currentQuery.type == ACTION_QUERY) {
 				/*
@@ -132,22 +150,12 @@ struct QuerySelector {
 				 * then suggest new queries which would now include the objects that afford the 
 				 * selected action.
 				 */
-				std::vector<Query> pruned;
-				for (size_t i = 0; i < generator.queries.size(); i++) {
-					if (generator.queries[i].hasObject && generator.queries[i].hasAction && generator.queries[i].actionIndex == currentQuery.actionIndex) {
-						pruned.push_back(generator.queries[i]);
-					}
-				}
-				generator.queries.clear();
-				generator.queries = pruned;
-				currentQuery = generator.queries[0];
+				prune(NotPairedWithAction(currentQuery.actionIndex));
 
 				if (currentQuery.hasAction) {
 					observedVars.actionIndex = currentQuery.actionIndex;
 				}
 
-				//NetworkUpdater::observe(*generator.network, observedVars);
-
 			} else if (currentQuery.type == OBJECT_QUERY) {
 				/*
 				 * If the user responds positively to an object query, which is a query 
@@ -156,63 +164,25 @@ struct QuerySelector {
 				 * then suggest new queries which would now include the actions that the selected
 				 * object affords.
 				 */
-				std::vector<Query> pruned;
-				for (size_t i = 0; i < generator.queries.size(); i++) {
-					if (generator.queries[i].hasAction && generator.queries[i].hasObject && generator.queries[i].objectIndex == currentQuery.objectIndex) {
-						pruned.push_back(generator.queries[i]);
-					}
-				}
-				generator.queries.clear();
-				generator.queries = pruned;
-				currentQuery = generator.queries[0];
+				prune(NotPairedWithObject(currentQuery.objectIndex));
 
 				if (currentQuery.hasObject) {
 					observedVars.objectIndex = currentQuery.objectIndex;										
 				}
-
-				//NetworkUpdater::observe(*generator.network, observedVars);
 			}
 
 		} else {
 			/*
-			 * With this design, the network is never updated based on a negative answer.
-			 * FIXME: Should we observe negative feedback in the network???
+			 * The network is never updated based on a negative answer. The rejected
+			 * pair is reported through observedVars, so that the caller can learn from
+			 * it (see ObjectActionRecognizer::setNegativeLearningRate).
 			 */
 			if (currentQuery.type == FULL_QUERY) {
 				/*
 				 * Remove the rejected full query from the query list as well as orphaned
 				 * object or action queries as a result of the rejection of this full query
 				 */
-				std::vector<Query> pruned;
-				std::vector<size_t> orphans;
-
-				for (size_t i = 0; i < generator.queries.size(); i++) {
-					if (generator.queries[i].index != currentQuery.index) {
-						if (generator.queries[i].type == OBJECT_QUERY && generator.queries[i].objectIndex == currentQuery.objectIndex) {							
-							orphans.push_back(generator.queries[i].index);
-						}
-						else if (generator.queries[i].type == ACTION_QUERY && generator.queries[i].actionIndex == currentQuery.actionIndex) {
-							orphans.push_back(generator.queries[i].index);
-						}
-					}
-				}
-				for (size_t j = 0; j < orphans.size(); j++) {
-					for (size_t k = 0; k < generator.queries.size(); k++) {
-						if (generator.queries[k].index == orphans[j]) {
-							generator.queries.erase(generator.queries.begin() + k);
-							break;
-						}
-					}
-				}
-				
-				for (size_t i = 0; i < generator.queries.size(); i++) {
-					if (generator.queries[i].index != currentQuery.index) {						
-						pruned.push_back(generator.queries[i]);
-					}
-				}
-				generator.queries.clear();
-				generator.queries = pruned;
-				currentQuery = generator.queries[0];
+				prune(OrphanedByRejection(currentQuery));
 
 				if (currentQuery.hasAction) {
 					observedVars.actionIndex = currentQuery.actionIndex;										
@@ -221,61 +191,58 @@ struct QuerySelector {
 					observedVars.objectIndex = currentQuery.objectIndex;										
 				}
 
-				//NetworkUpdater::observe(*generator.network, observedVars);
-
 			} else if (currentQuery.type == ACTION_QUERY) {
 				/*
 				 * Remove the rejected action query, along with any other queries involving
 				 * the action.
 				 */
-				std::vector<Query> pruned;
-				for (size_t i = 0; i < generator.queries.size(); i++) {
-					if (/* generator.queries[i].hasAction && */ generator.queries[i].actionIndex != currentQuery.actionIndex) {
-						//generator.queries.erase(generator.queries.begin() + i);
-						pruned.push_back(generator.queries[i]);
-					}
-				}
-				
-				generator.queries.clear();
-				generator.queries = pruned;
-				currentQuery = generator.queries[0];
-
-				//if (currentQuery.hasAction) {
-				//	observedVars.actionIndex = currentQuery.actionIndex;										
-				//}		
-
-				//NetworkUpdater::observe(*generator.network, observedVars);
+				prune(InvolvesAction(currentQuery.actionIndex));
 
 			} else if (currentQuery.type == OBJECT_QUERY) {
 				/*
 				 * Remove the rejected object query, along with any other queries involving
 				 * the object.
 				 */
-				std::vector<Query> pruned;
-				for (size_t i = 0; i < generator.queries.size(); i++) {
-					if (/* generator.queries[i].hasObject && */ generator.queries[i].objectIndex != currentQuery.objectIndex) {
-						//generator.queries.erase(generator.queries.begin() + i);
-						pruned.push_back(generator.queries[i]);
-					}
-				}
-				
-				generator.queries.clear();
-				generator.queries = pruned;
-				currentQuery = generator.queries[0];
-
-				//if (currentQuery.hasObject) {
-				//	observedVars.objectIndex = currentQuery.objectIndex;										
-				//}
-
-				//NetworkUpdater::observe(*generator.network, observedVars);
+				prune(InvolvesObject(currentQuery.objectIndex));
 			}
 
 		}
 		
-		this->network = *generator.network->clone();
-		//observedVars.clear();
 		return (selectionComplete);
 	}
+
+
+private:
+	/**
+	 * \brief Generates the query set on first use, unless the caller already generated it,
+	 * and restores it if \c reset is set
+	 */
+	void prepareQueries(const bool& reset) {
+		if (!generated) {
+			if (generator.queries.empty()) {
+				generator.generateQuerySet();
+			}
+			initialQueries = generator.queries;
+			generated = true;
+
+		} else if (reset) {
+			generator.queries = initialQueries;
+		}
+	}
+
+	/**
+	 * \brief Removes the remaining queries matched by \c pred, keeping the others in rank
+	 * order, and moves on to the highest ranked query left
+	 */
+	template <typename Predicate>
+	void prune(Predicate pred) {
+		std::vector<Query>& queries = generator.queries;
+		queries.erase(std::remove_if(queries.begin(), queries.end(), pred), queries.end());
+
+		if (!queries.empty()) {
+			currentQuery = queries[0];
+		}
+	}
 	
 };
 
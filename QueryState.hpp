@@ -0,0 +1,391 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file QueryState.hpp
+ *	\brief The part of a recognition session that changes with every answer
+ *	\author	Kester Duncan
+ */
+#ifndef __QUERY_STATE_H__
+#define __QUERY_STATE_H__
+
+#include <cstdlib>
+#include <vector>
+#include "Query.hpp"
+#include "QueryHeap.hpp"
+#include "QueryStream.hpp"
+#include "QueryGroupTable.hpp"
+#include "QueryPlanner.h"
+#include "QueryLookahead.hpp"
+
+
+namespace oar {
+
+
+/**
+ * \brief The part of a recognition session that changes with every answer
+ *
+ * It holds the remaining queries, the query being proposed and the progress along a
+ * planned policy, and applies the answers of the user to them. A state is a plain
+ * value, so the outcome of an answer can be computed on a copy (see SpeculativeEvaluator)
+ * without touching the session.
+ */
+class QueryState {
+public:
+	/// The remaining queries, ranked lazily
+	QueryStream queries;
+
+	/// The query being proposed to the user
+	Query currentQuery;
+
+	/// Groups of objects referred to by group queries
+	QueryGroupTable groups;
+
+	/// Index given to the next query added to the query set
+	int nextQueryIndex;
+
+	/// Current step of the planned policy, or -1 once the policy can no longer be followed
+	int policyStep;
+
+	/// Indicates whether group queries are regenerated after every answer
+	bool useGroupQueries;
+
+	/// Indicates whether \c currentQuery has been selected since the last answer
+	bool querySelected;
+
+	/// Objects of the scene that the answers have not ruled out, along with the actions they afford
+	SceneAffordances scene;
+
+	/// Indicates whether the query set refers to the nodes of \c scene
+	bool sceneTracked;
+
+
+	/// Default constructor
+	QueryState() : nextQueryIndex(0), policyStep(-1), useGroupQueries(false), querySelected(false),
+		sceneTracked(false) {}
+
+	/**
+	 * \brief Starts a new query set, ranked by \c order
+	 *
+	 * If the queries refer to the nodes of a scene, \c sceneAffordances gives the objects of
+	 * the scene and the actions they afford, which are then pruned along with the queries.
+	 */
+	void assign(const std::vector<Query>& querySet, const QueryOrder& order = QueryOrder(),
+		const SceneAffordances* sceneAffordances = NULL)
+	{
+		queries.assign(querySet, order);
+		policyStep = -1;
+		querySelected = false;
+
+		if (sceneAffordances != NULL) {
+			scene = *sceneAffordances;
+			sceneTracked = true;
+		} else {
+			scene.clear();
+			sceneTracked = false;
+		}
+	}
+
+	/// Removes all queries and groups
+	void clear() {
+		queries.clear();
+		groups.clear();
+		currentQuery = Query();
+		nextQueryIndex = 0;
+		policyStep = -1;
+		querySelected = false;
+		scene.clear();
+		sceneTracked = false;
+	}
+
+	/**
+	 * \brief Selects the query to propose: the next step of \c policy if it is being
+	 * followed, the choice of \c lookahead if there is one, or the highest ranked query
+	 */
+	void select(const QueryPolicy* policy, const std::vector<Query>& plannedQueries, QueryLookahead* lookahead) {
+		if (policy != NULL && policyStep >= 0) {
+			currentQuery = plannedQueries[policy->nodes[policyStep].queryIndex];
+
+		} else if (lookahead != NULL && !queries.empty()) {
+			std::vector<Query> ranked = queries.ranked();
+			currentQuery = ranked[lookahead->select(ranked, &groups)];
+
+		} else if (!queries.empty()) {
+			currentQuery = queries.top();
+		}
+
+		querySelected = true;
+	}
+
+	/**
+	 * \brief Applies the answer of the user to the current query
+	 * \return True if the answer recognizes the intention
+	 */
+	bool applyAnswer(const bool& wasSelected, const QueryPolicy* policy) {
+		bool intentionRecognized = false;
+
+		followPolicy(wasSelected, policy);
+		querySelected = false;
+
+		if (wasSelected == true) {	
+			/*
+			 * Query Accepted
+			 */
+			if (currentQuery.type == FULL_QUERY) {
+				/*
+				 * If the user responds positively to a full query, which is a query involving
+				 * an object and an action, we are done. There is no need to ask them any more
+				 * questions. We simply 'perform' the chosen action on the chosen object.
+				 */
+				intentionRecognized = true;			
+
+			} else if (currentQuery.type == ACTION_QUERY) {
+				/*
+				 * If the user responds positively to an action query, which is a query 
+				 * only involving an action, we prune the current query set to determine only
+				 * those queries that involve the chosen action together with an object. We would 
+				 * then suggest new queries which would now include the objects that afford the 
+				 * selected action.
+				 */
+				queries.removeIf(NotPairedWithAction(currentQuery.actionIndex));
+
+			} else if (currentQuery.type == OBJECT_QUERY) {
+				/*
+				 * If the user responds positively to an object query, which is a query 
+				 * only involving an object, we prune the current query set to determine only
+				 * those queries that involve the chosen object together with an action. We would 
+				 * then suggest new queries which would now include the actions that the selected
+				 * object affords.
+				 */
+				queries.removeIf(NotPairedWithObject(currentQuery.objectIndex));
+				keepSceneObjects(OutsideObject(currentQuery.objectIndex));
+
+			} else if (currentQuery.type == GROUP_QUERY) {
+				/*
+				 * If the user responds positively to a group query, only the objects of the
+				 * group remain, along with the actions that they afford.
+				 */
+				queries.removeIf(OutsideGroup(groups, currentQuery.groupIndex));
+				keepSceneObjects(OutsideGroupMembers(groups, currentQuery.groupIndex));
+				pruneUnaffordedActions();
+			}
+
+		} else {
+			/*
+			 * Query Rejected
+			 */
+			if (currentQuery.type == FULL_QUERY) {
+				/*
+				 * Remove the rejected full query from the query list as well as orphaned
+				 * object or action queries as a result of the rejection of this full query
+				 */
+				queries.removeIf(OrphanedByRejection(currentQuery));
+
+			} else if (currentQuery.type == ACTION_QUERY) {
+				/*
+				 * Remove the rejected action query, along with any other queries involving
+				 * the action.
+				 */
+				queries.removeIf(InvolvesAction(currentQuery.actionIndex));
+
+			} else if (currentQuery.type == OBJECT_QUERY) {
+				/*
+				 * Remove the rejected object query, along with any other queries involving
+				 * the object.
+				 */
+				queries.removeIf(InvolvesObject(currentQuery.objectIndex));
+				removeSceneObject(currentQuery.objectIndex);
+
+			} else if (currentQuery.type == GROUP_QUERY) {
+				/*
+				 * Remove the rejected group query, along with any queries involving the
+				 * objects of the group and the actions that only they afford.
+				 */
+				const std::vector<int>& members = groups.members(currentQuery.groupIndex);
+
+				queries.removeIf(InvolvesGroup(groups, currentQuery.groupIndex));
+				for (size_t i = 0; i < members.size(); i++) {
+					removeSceneObject(members[i]);
+				}
+				pruneUnaffordedActions();
+			}
+		}
+
+		if (intentionRecognized) {
+			return true;
+		}
+
+		/*
+		 * Split the remaining intentions with a new group query, unless a planned policy
+		 * that already accounts for the group queries is being followed
+		 */
+		if (useGroupQueries && (policy == NULL || policyStep < 0)) {
+			refreshGroupQuery();
+		}
+
+		if (!queries.empty()) {
+			currentQuery = queries.top();
+		}
+
+		return false;
+	}
+
+	/**
+	 * \brief Creates a group query that splits the intentions of \c querySet roughly in half
+	 * and ranks it above every query in \c querySet
+	 * \return False if no such group is worth asking about
+	 */
+	bool createGroupQuery(const std::vector<Query>& querySet, Query& groupQuery) {
+		double groupMass;
+		int group = groups.addHalvingGroup(querySet, groupMass);
+
+		if (group < 0) {
+			return false;
+		}
+
+		groupQuery = Query(nextQueryIndex, groupMass);
+		groupQuery.type = GROUP_QUERY;
+		groupQuery.groupIndex = group;
+		nextQueryIndex++;
+
+		/*
+		 * A group query rules out about half of the remaining intentions whatever the
+		 * answer, so it is proposed before any single intention. There is never more
+		 * than one group query in a query set, so it needs no tie-break key.
+		 */
+		for (size_t i = 0; i < querySet.size(); i++) {
+			if (querySet[i].rankScore >= groupQuery.rankScore) {
+				groupQuery.rankScore = querySet[i].rankScore + 1;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * \brief Replaces the group query of the query list with one that splits the
+	 * remaining intentions
+	 */
+	void refreshGroupQuery() {
+		Query groupQuery;
+
+		queries.removeIf(IsGroupQuery());
+
+		if (createGroupQuery(queries.unordered(), groupQuery)) {
+			queries.push(groupQuery);
+		}
+	}
+
+
+private:
+	/// Matches the objects other than \c objectIndex
+	struct OutsideObject {
+		int objectIndex;
+
+		OutsideObject(const int& o) : objectIndex(o) {}
+
+		bool operator() (const int& o) const {
+			return (o != objectIndex);
+		}
+	};
+
+	/// Matches the objects outside of \c group
+	struct OutsideGroupMembers {
+		const QueryGroupTable* groups;
+		int group;
+
+		OutsideGroupMembers(const QueryGroupTable& table, const int& g) : groups(&table), group(g) {}
+
+		bool operator() (const int& o) const {
+			return !groups->contains(group, o);
+		}
+	};
+
+
+	/// Removes the object \c objectIndex from the tracked scene
+	void removeSceneObject(const int& objectIndex) {
+		if (sceneTracked && objectIndex >= 0) {
+			scene.removeObject(objectIndex);
+		}
+	}
+
+	/// Removes every object of the tracked scene that \c outside matches
+	template <typename ObjectPredicate>
+	void keepSceneObjects(const ObjectPredicate& outside) {
+		if (!sceneTracked) {
+			return;
+		}
+
+		const NodeSet objects = scene.getObjects();
+
+		for (NodeSet::size_type o = objects.find_first(); o != NodeSet::npos; o = objects.find_next(o)) {
+			if (outside(static_cast<int>(o))) {
+				scene.removeObject(o);
+			}
+		}
+	}
+
+	/**
+	 * \brief Removes the action queries left without an object to perform them on
+	 *
+	 * When the queries refer to a scene, these are the actions that none of its remaining
+	 * objects afford; otherwise they are found from the remaining <object, action> queries.
+	 */
+	void pruneUnaffordedActions() {
+		if (sceneTracked) {
+			queries.removeIf(ActionNotAfforded(scene));
+		} else {
+			queries.removeIf(ActionWithoutIntention(queries.unordered()));
+		}
+	}
+
+	/// Moves along \c policy according to the answer to the current query
+	void followPolicy(const bool& wasSelected, const QueryPolicy* policy) {
+		if (policy == NULL || policyStep < 0) {
+			return;
+		}
+
+		const PolicyNode& step = policy->nodes[policyStep];
+
+		if (step.queryIndex != currentQuery.index) {
+			// A query outside of the policy was answered, so fall back to the ranking
+			policyStep = -1;
+		} else {
+			policyStep = (wasSelected ? step.yes : step.no);
+		}
+	}
+
+};
+
+
+} /* oar */
+
+#endif /* __QUERY_STATE_H__ */
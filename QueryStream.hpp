@@ -0,0 +1,281 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file QueryStream.hpp
+ *	\brief Score-ordered stream of queries merged lazily from one heap per query type
+ *	\author	Kester Duncan
+ */
+#ifndef __QUERY_STREAM_H__
+#define __QUERY_STREAM_H__
+
+#include <cstdlib>
+#include <vector>
+#include "Query.hpp"
+#include "QueryHeap.hpp"
+
+
+namespace oar {
+
+
+/**
+ * \brief Yields the queries of a scene in ranked order, merged on demand from one
+ * lazily ranked heap per query type
+ *
+ * The action, object, <object, action> and group queries are heapified independently
+ * as they are assigned, and the global order is produced by a k-way merge of the
+ * heads of the heaps, so that it agrees with the ordering (including the preference
+ * of QueryComparator for full queries on equal scores). Most sessions end within a
+ * few questions, so only the heads of the heaps are ever ranked. Queries of a single
+ * type, e.g. the full queries that are presented to the user, are reached without
+ * visiting the others.
+ *
+ * If no ordering is given, the queries are proposed in the order in which they were
+ * provided, so they are kept in a single heap.
+ */
+class QueryStream {
+public:
+	/// Default constructor
+	QueryStream() : count(0) {}
+
+	/**
+	 * \brief Replaces the contents of the stream with \c querySet ranked by \c ord
+	 */
+	void assign(const std::vector<Query>& querySet, const QueryOrder& ord = QueryOrder()) {
+		std::vector<Query> byType[NUM_LISTS];
+
+		order = ord;
+		count = querySet.size();
+
+		for (size_t i = 0; i < querySet.size(); i++) {
+			byType[listOf(querySet[i])].push_back(querySet[i]);
+		}
+
+		for (int t = 0; t < NUM_LISTS; t++) {
+			lists[t].assign(byType[t], order);
+		}
+	}
+
+	/// Removes all queries
+	void clear() {
+		for (int t = 0; t < NUM_LISTS; t++) {
+			lists[t].clear();
+		}
+		count = 0;
+	}
+
+	/// Indicates whether there are any queries left
+	bool empty() const {
+		return (count == 0);
+	}
+
+	/// Number of queries left
+	size_t size() const {
+		return count;
+	}
+
+	/**
+	 * \brief Gets the highest ranked query
+	 * \remarks The stream must not be empty
+	 */
+	const Query& top() const {
+		return lists[best()].top();
+	}
+
+	/**
+	 * \brief Removes and returns the highest ranked query
+	 */
+	Query pop() {
+		count--;
+		return lists[best()].pop();
+	}
+
+	/**
+	 * \brief Inserts a query into the ranking
+	 */
+	void push(const Query& q) {
+		lists[listOf(q)].push(q);
+		count++;
+	}
+
+	/**
+	 * \brief Removes every query for which \c pred returns true
+	 * \return The number of queries removed
+	 */
+	template <typename Predicate>
+	size_t removeIf(Predicate pred) {
+		size_t removed = 0;
+
+		for (int t = 0; t < NUM_LISTS; t++) {
+			removed += lists[t].removeIf(pred);
+		}
+
+		count -= removed;
+		return removed;
+	}
+
+	/**
+	 * \brief Gets the \c k highest ranked queries, best first, without removing them
+	 *
+	 * Each heap contributes at most its own top \c k, which are merged in O(k).
+	 */
+	std::vector<Query> peek(const size_t& k) const {
+		std::vector<Query> heads[NUM_LISTS];
+		size_t next[NUM_LISTS];
+		std::vector<Query> best;
+
+		for (int t = 0; t < NUM_LISTS; t++) {
+			heads[t] = lists[t].peek(k);
+			next[t] = 0;
+		}
+
+		while (best.size() < k) {
+			int winner = -1;
+
+			for (int t = 0; t < NUM_LISTS; t++) {
+				if (next[t] < heads[t].size() &&
+					(winner < 0 || precedes(heads[t][next[t]], heads[winner][next[winner]]))) {
+					winner = t;
+				}
+			}
+
+			if (winner < 0) {
+				break;
+			}
+
+			best.push_back(heads[winner][next[winner]]);
+			next[winner]++;
+		}
+
+		return best;
+	}
+
+	/**
+	 * \brief Gets the \c k highest ranked queries of type \c type, best first, without
+	 * ranking the queries of the other types
+	 */
+	std::vector<Query> peek(const size_t& k, const QueryType& type) const {
+		if (order) {
+			return lists[type].peek(k);
+		}
+
+		// All queries share a single heap, which is ranked until \c k of the type are found
+		std::vector<Query> remaining = lists[UNKNOWN].ranked();
+		std::vector<Query> best;
+
+		for (size_t i = 0; i < remaining.size() && best.size() < k; i++) {
+			if (remaining[i].type == type) {
+				best.push_back(remaining[i]);
+			}
+		}
+
+		return best;
+	}
+
+	/**
+	 * \brief Gets all of the remaining queries in ranked order
+	 */
+	std::vector<Query> ranked() const {
+		return peek(count);
+	}
+
+	/**
+	 * \brief Gets all of the remaining queries of type \c type in ranked order
+	 */
+	std::vector<Query> ranked(const QueryType& type) const {
+		return peek(count, type);
+	}
+
+	/**
+	 * \brief Gets all of the remaining queries in no particular order, without ranking them
+	 */
+	std::vector<Query> unordered() const {
+		std::vector<Query> remaining;
+		remaining.reserve(count);
+
+		for (int t = 0; t < NUM_LISTS; t++) {
+			std::vector<Query> part = lists[t].unordered();
+			remaining.insert(remaining.end(), part.begin(), part.end());
+		}
+
+		return remaining;
+	}
+
+
+private:
+	/// One heap per query type; UNKNOWN holds every query when there is no ordering
+	enum { NUM_LISTS = UNKNOWN + 1 };
+
+	/// Queries of each type, ranked lazily
+	QueryHeap lists[NUM_LISTS];
+
+	/// Ordering of the queries
+	QueryOrder order;
+
+	/// Number of queries left
+	size_t count;
+
+
+	/// Gets the heap that holds \c q
+	int listOf(const Query& q) const {
+		if (!order || q.type < ACTION_QUERY || q.type > GROUP_QUERY) {
+			return UNKNOWN;
+		}
+		return q.type;
+	}
+
+	/// Determines whether \c lhs ranks higher than \c rhs
+	bool precedes(const Query& lhs, const Query& rhs) const {
+		return order ? order(lhs, rhs) : false;
+	}
+
+	/**
+	 * \brief Gets the heap whose highest ranked query ranks highest overall
+	 * \remarks The stream must not be empty
+	 */
+	int best() const {
+		int winner = -1;
+
+		for (int t = 0; t < NUM_LISTS; t++) {
+			if (!lists[t].empty() && (winner < 0 || precedes(lists[t].top(), lists[winner].top()))) {
+				winner = t;
+			}
+		}
+
+		return winner;
+	}
+
+};
+
+
+} /* oar */
+
+#endif /* __QUERY_STREAM_H__ */
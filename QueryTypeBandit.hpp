@@ -0,0 +1,237 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file QueryTypeBandit.hpp
+ *	\brief Thompson sampling over the types of questions asked first
+ *	\author	Kester Duncan
+ */
+#ifndef __QUERY_TYPE_BANDIT_H__
+#define __QUERY_TYPE_BANDIT_H__
+
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/gamma_distribution.hpp>
+#include "Query.hpp"
+
+
+namespace oar {
+
+
+/**
+ * \brief Learns which types of questions lead to a quick recognition for a user and
+ * biases the ranking of the queries towards them
+ *
+ * Every query type (action, object and full) has a Beta posterior over the probability
+ * that a session which asks questions of that type is resolved quickly, kept separately
+ * for each context. The context is the size of the scene, bucketed by powers of two of
+ * its number of intentions, because whether asking about an action or an object first
+ * pays off depends on how many of each there are. When a query set is ranked, a
+ * probability is drawn from every posterior (Thompson sampling) and the scores of the
+ * queries are weighted by the draw for their type.
+ *
+ * A session that recognizes the intention after n questions earns the reward 1 / n,
+ * shared among the query types in proportion to the questions of each type that were
+ * asked, as a fractional Beta update. Counting the questions costs O(1) per answer and
+ * the update O(1) per session.
+ */
+class QueryTypeBandit {
+public:
+	/// Number of query types that are learned
+	static const size_t NUM_TYPES = 3;
+
+	/**
+	 * \brief Constructs a bandit with uniform Beta(\c priorAccepted, \c priorRejected)
+	 * priors over \c numContexts scene sizes
+	 */
+	explicit QueryTypeBandit(const unsigned int& seed = 0, const size_t& numContexts = 6,
+			const double& priorAccepted = 1., const double& priorRejected = 1.) :
+		rng(seed), numContexts(numContexts > 0 ? numContexts : 1),
+		accepted(this->numContexts * NUM_TYPES, priorAccepted),
+		rejected(this->numContexts * NUM_TYPES, priorRejected) {}
+
+	/// Seeds the random draws
+	void seed(const unsigned int& s) {
+		rng.seed(s);
+	}
+
+	/**
+	 * \brief Gets the context of a scene with \c numIntentions intentions
+	 */
+	size_t context(size_t numIntentions) const {
+		size_t ctx = 0;
+
+		while (numIntentions > 1 && ctx + 1 < numContexts) {
+			numIntentions >>= 1;
+			ctx++;
+		}
+
+		return ctx;
+	}
+
+	/**
+	 * \brief Draws the acceptance probability of every query type in context \c ctx
+	 * from its posterior
+	 */
+	std::vector<double> sample(const size_t& ctx) {
+		std::vector<double> theta (NUM_TYPES, 1.);
+
+		for (size_t t = 0; t < NUM_TYPES; t++) {
+			boost::random::gamma_distribution<double> acceptedDraw (accepted[slot(ctx, t)]);
+			boost::random::gamma_distribution<double> rejectedDraw (rejected[slot(ctx, t)]);
+			double x = acceptedDraw(rng);
+			double y = rejectedDraw(rng);
+
+			theta[t] = (x + y > 0.) ? x / (x + y) : 0.5;
+		}
+
+		return theta;
+	}
+
+	/**
+	 * \brief Weights the rank scores of \c querySet by the acceptance probabilities
+	 * \c theta drawn for their types. Queries of other types are left as they are.
+	 */
+	void weigh(std::vector<Query>& querySet, const std::vector<double>& theta) const {
+		for (size_t i = 0; i < querySet.size(); i++) {
+			Query& q = querySet[i];
+
+			if (isLearned(q.type)) {
+				q.rankScore = Query::quantizeScore(q.score * theta[q.type]);
+			}
+		}
+	}
+
+	/**
+	 * \brief Records a session of context \c ctx that recognized the intention after
+	 * \c numInteractions questions, \c asked[t] of which were of type t
+	 */
+	void recordSession(const size_t& ctx, const std::vector<size_t>& asked, const size_t& numInteractions) {
+		if (ctx >= numContexts || numInteractions == 0) {
+			return;
+		}
+
+		const double reward = 1. / numInteractions;
+
+		for (size_t t = 0; t < NUM_TYPES && t < asked.size(); t++) {
+			const double share = static_cast<double>(asked[t]) / numInteractions;
+
+			accepted[slot(ctx, t)] += share * reward;
+			rejected[slot(ctx, t)] += share * (1. - reward);
+		}
+	}
+
+	/// Posterior mean of the probability that asking questions of \c type in context \c ctx resolves a session quickly
+	double getSuccessRate(const size_t& ctx, const QueryType& type) const {
+		if (!isLearned(type) || ctx >= numContexts) {
+			return 0.;
+		}
+
+		const size_t s = slot(ctx, type);
+		return accepted[s] / (accepted[s] + rejected[s]);
+	}
+
+	/// Determines whether queries of type \c type are learned
+	static bool isLearned(const QueryType& type) {
+		return (type == ACTION_QUERY || type == OBJECT_QUERY || type == FULL_QUERY);
+	}
+
+	/**
+	 * \brief Reads the posteriors from \c fileName
+	 */
+	void readPosteriors(const std::string& fileName) {
+		std::ifstream inFile;
+		inFile.open(fileName.c_str(), std::ios::in);
+
+		if (inFile.is_open()) {
+			size_t ctx, type;
+			double a, r;
+
+			while (inFile >> ctx >> type >> a >> r) {
+				if (ctx < numContexts && type < NUM_TYPES) {
+					accepted[slot(ctx, type)] = a;
+					rejected[slot(ctx, type)] = r;
+				}
+			}
+
+			inFile.close();
+
+		} else {
+			std::cerr << "QueryTypeBandit: Unable to open file " << fileName << " for reading!\n";
+		}
+	}
+
+	/**
+	 * \brief Writes the posteriors to \c fileName
+	 */
+	void writePosteriors(const std::string& fileName) const {
+		std::ofstream outFile;
+		outFile.open(fileName.c_str(), std::ios::out);
+
+		if (outFile.is_open()) {
+			for (size_t ctx = 0; ctx < numContexts; ctx++) {
+				for (size_t t = 0; t < NUM_TYPES; t++) {
+					outFile << ctx << " " << t << " " << accepted[slot(ctx, t)] << " " << rejected[slot(ctx, t)] << std::endl;
+				}
+			}
+
+			outFile.close();
+
+		} else {
+			std::cerr << "QueryTypeBandit: Unable to open file " << fileName << " for writing!\n";
+		}
+	}
+
+
+private:
+	boost::random::mt19937 rng;
+	size_t numContexts;
+
+	/// Beta parameters, indexed by context and then by query type
+	std::vector<double> accepted;
+	std::vector<double> rejected;
+
+
+	/// Position of the posterior of \c type in context \c ctx
+	static size_t slot(const size_t& ctx, const size_t& type) {
+		return ctx * NUM_TYPES + type;
+	}
+
+};
+
+
+} /* oar */
+
+#endif /* __QUERY_TYPE_BANDIT_H__ */
@@ -0,0 +1,167 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file SceneAffordances.hpp
+ *	\brief Bitsets of the objects of a scene that afford each action
+ *	\author	Kester Duncan
+ */
+#ifndef __SCENE_AFFORDANCES_H__
+#define __SCENE_AFFORDANCES_H__
+
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <boost/dynamic_bitset.hpp>
+
+
+namespace oar {
+
+
+/// Set of network nodes, one bit per node label
+typedef boost::dynamic_bitset<> NodeSet;
+
+
+/**
+ * \brief Tracks which object instances of a scene afford each action
+ *
+ * For every action node there is a bitset of the object nodes that afford it, and for
+ * every object node the list of action nodes it affords, so that objects can be added
+ * to or removed from the scene without rebuilding anything. Both kinds of node are
+ * identified by their labels in the network.
+ */
+class SceneAffordances {
+public:
+	SceneAffordances() {}
+
+	/// Removes all objects and actions
+	void clear() {
+		objectsByAction.clear();
+		actionsByObject.clear();
+		objects.clear();
+	}
+
+	/**
+	 * \brief Adds the object node \c objectLabel, which affords the action nodes \c actionLabels
+	 */
+	void addObject(const size_t& objectLabel, const std::vector<size_t>& actionLabels) {
+		removeObject(objectLabel);
+		reserve(objectLabel + 1);
+
+		for (size_t i = 0; i < actionLabels.size(); i++) {
+			if (objectsByAction.size() <= actionLabels[i]) {
+				objectsByAction.resize(actionLabels[i] + 1, NodeSet(objects.size()));
+			}
+			objectsByAction[actionLabels[i]].set(objectLabel);
+		}
+
+		actionsByObject[objectLabel] = actionLabels;
+		objects.set(objectLabel);
+	}
+
+	/**
+	 * \brief Removes the object node \c objectLabel from the scene
+	 */
+	void removeObject(const size_t& objectLabel) {
+		if (objectLabel >= actionsByObject.size() || !objects.test(objectLabel)) {
+			return;
+		}
+
+		const std::vector<size_t>& actionLabels = actionsByObject[objectLabel];
+
+		for (size_t i = 0; i < actionLabels.size(); i++) {
+			objectsByAction[actionLabels[i]].reset(objectLabel);
+		}
+
+		actionsByObject[objectLabel].clear();
+		objects.reset(objectLabel);
+	}
+
+	/// Gets the object nodes of the scene
+	const NodeSet& getObjects() const {
+		return objects;
+	}
+
+	/**
+	 * \brief Gets the object nodes that afford the action node \c actionLabel
+	 */
+	NodeSet objectsAffording(const size_t& actionLabel) const {
+		if (actionLabel >= objectsByAction.size()) {
+			return NodeSet(objects.size());
+		}
+		return objectsByAction[actionLabel];
+	}
+
+	/// Determines whether the object node \c objectLabel affords the action node \c actionLabel
+	bool affords(const size_t& objectLabel, const size_t& actionLabel) const {
+		return (actionLabel < objectsByAction.size() && objectLabel < objects.size()
+			&& objectsByAction[actionLabel].test(objectLabel));
+	}
+
+	/// Determines whether any object of the scene affords the action node \c actionLabel
+	bool isAfforded(const size_t& actionLabel) const {
+		return (actionLabel < objectsByAction.size() && objectsByAction[actionLabel].any());
+	}
+
+
+private:
+	/// Object nodes affording each action node, indexed by action label
+	std::vector<NodeSet> objectsByAction;
+
+	/// Action nodes afforded by each object node, indexed by object label
+	std::vector< std::vector<size_t> > actionsByObject;
+
+	/// Object nodes currently in the scene
+	NodeSet objects;
+
+
+	/// Makes room for nodes with labels below \c numLabels, doubling the room when it grows
+	void reserve(const size_t& numLabels) {
+		if (objects.size() >= numLabels) {
+			return;
+		}
+
+		const size_t room = std::max(numLabels, 2 * objects.size());
+
+		objects.resize(room);
+		actionsByObject.resize(room);
+
+		for (size_t i = 0; i < objectsByAction.size(); i++) {
+			objectsByAction[i].resize(room);
+		}
+	}
+
+};
+
+
+} /* oar */
+
+#endif /* __SCENE_AFFORDANCES_H__ */
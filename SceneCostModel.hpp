@@ -0,0 +1,137 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file SceneCostModel.hpp
+ *	\brief Measured cost of scoring a scene, shared by the recognizers of successive scenes
+ *	\author	Kester Duncan
+ */
+#ifndef __SCENE_COST_MODEL_H__
+#define __SCENE_COST_MODEL_H__
+
+#include <cstdlib>
+#include <vector>
+
+
+namespace oar {
+
+
+/**
+ * \brief What is known about the cost of scoring a scene, kept across scenes
+ *
+ * A recognizer scores one scene, so its measurements are lost with it unless they are
+ * kept by the caller, as the query planner and the query type bandit are. The model
+ * holds a running estimate of the time an inference sweep takes per factor, from which
+ * a recognizer chooses the scoring tier of a scene before running anything, and the
+ * prior score of every <object, action> template, which ranks the scenes that have no
+ * time left for inference. The priors depend on the template map, so the model should
+ * be shared only by recognizers of the same map; they are dropped whenever the map is
+ * updated.
+ */
+class SceneCostModel {
+public:
+	SceneCostModel() : sweepMillisPerFactor(0.), numActions(0) {}
+
+	/// Gets the estimated time of an inference sweep over \c numFactors factors, 0 until one is measured
+	double estimateSweepMillis(const size_t& numFactors) const {
+		return sweepMillisPerFactor * numFactors;
+	}
+
+	/**
+	 * \brief Records that \c numSweeps inference sweeps over \c numFactors factors took
+	 * \c millis milliseconds
+	 */
+	void recordInference(const double& millis, const size_t& numSweeps, const size_t& numFactors) {
+		if (numSweeps == 0 || numFactors == 0) {
+			return;
+		}
+
+		const double perFactor = millis / (numSweeps * numFactors);
+
+		// Exponentially weighted, so that the estimate follows changes of the load of the machine
+		if (sweepMillisPerFactor > 0.) {
+			sweepMillisPerFactor = 0.8 * sweepMillisPerFactor + 0.2 * perFactor;
+		} else {
+			sweepMillisPerFactor = perFactor;
+		}
+	}
+
+	/// Gets the estimated time of an inference sweep per factor in milliseconds
+	double getSweepMillisPerFactor() const {
+		return sweepMillisPerFactor;
+	}
+
+	/// Indicates whether the prior scores of the templates are known
+	bool hasTemplatePriors() const {
+		return !templatePriors.empty();
+	}
+
+	/**
+	 * \brief Sets the prior scores of the templates, \c priors[o * numActs + a] being the
+	 * score of the <object, action> template (o, a)
+	 */
+	void setTemplatePriors(const std::vector<double>& priors, const size_t& numActs) {
+		templatePriors = priors;
+		numActions = numActs;
+	}
+
+	/// Gets the prior score of the <object, action> template (\c objectIdx, \c actionIdx)
+	double getTemplatePrior(const size_t& objectIdx, const size_t& actionIdx) const {
+		const size_t idx = objectIdx * numActions + actionIdx;
+
+		if (actionIdx >= numActions || idx >= templatePriors.size()) {
+			return 0.;
+		}
+		return templatePriors[idx];
+	}
+
+	/// Drops the prior scores of the templates, e.g. after the template map was updated
+	void invalidateTemplatePriors() {
+		templatePriors.clear();
+	}
+
+
+private:
+	/// Running estimate of the time an inference sweep takes per factor, in milliseconds
+	double sweepMillisPerFactor;
+
+	/// Prior score of each <object, action> template, or empty if not known
+	std::vector<double> templatePriors;
+
+	/// Number of actions per object in \c templatePriors
+	size_t numActions;
+
+};
+
+
+} /* oar */
+
+#endif /* __SCENE_COST_MODEL_H__ */
@@ -0,0 +1,241 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file SceneInference.hpp
+ *	\brief Inference results of a scene network shared by its readers
+ *	\author	Kester Duncan
+ */
+#ifndef __SCENE_INFERENCE_H__
+#define __SCENE_INFERENCE_H__
+
+#include <cstdlib>
+#include <vector>
+#include <string>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <dai/daialg.h>
+#include <dai/factorgraph.h>
+#include <dai/varset.h>
+
+
+namespace oar {
+
+
+/**
+ * \brief The object-action intention network of a scene together with its beliefs
+ *
+ * Belief propagation is run at most once, when the object is constructed, and the
+ * beliefs of the object and action nodes and of the <object, action> factors are
+ * cached. The recognizer, the query generator and the query selector all read the
+ * same instance through a SceneInferencePtr, so a scene is neither copied nor
+ * inferred more than once. The object is never modified after construction and is
+ * therefore safe to read from several threads.
+ */
+class SceneInference : private boost::noncopyable {
+public:
+	/**
+	 * \brief Builds the network from \c factors and, if \c infer is set, runs inference on it
+	 * with the properties \c props
+	 */
+	explicit SceneInference(const std::vector<dai::Factor>& factors, const dai::PropertySet& props = defaultProperties(),
+			const bool& infer = true) :
+		graph(factors), algorithm(NULL), finalDiff(0.), isConverged(false) {
+		findRelations();
+
+		if (infer) {
+			run(props);
+		}
+	}
+
+	/// Copies \c net and runs inference on it
+	explicit SceneInference(const dai::FactorGraph& net, const dai::PropertySet& props = defaultProperties()) :
+		graph(net), algorithm(NULL), finalDiff(0.), isConverged(false) {
+		findRelations();
+		run(props);
+	}
+
+	~SceneInference() {
+		if (algorithm) {
+			delete algorithm;
+		}
+	}
+
+	/**
+	 * \brief Properties of the max-product belief propagation run on every scene
+	 */
+	static dai::PropertySet defaultProperties() {
+		dai::PropertySet infProps;
+		infProps.set("tol", 0.00000001);
+		infProps.set("logdomain", true);
+		infProps.set("updates", std::string("SEQMAX"));
+		infProps.set("inference", std::string("MAXPROD"));
+
+		return infProps;
+	}
+
+	/**
+	 * \brief Properties of a belief propagation run that stops after \c maxSeconds, converged
+	 * or not
+	 */
+	static dai::PropertySet anytimeProperties(const double& maxSeconds) {
+		dai::PropertySet infProps = defaultProperties();
+		infProps.set("maxtime", maxSeconds);
+
+		return infProps;
+	}
+
+	/// Indicates whether inference was run, i.e. whether there are beliefs
+	bool hasBeliefs() const {
+		return (algorithm != NULL);
+	}
+
+	/// Indicates whether inference ran until the beliefs converged to within its tolerance
+	bool converged() const {
+		return isConverged;
+	}
+
+	/// Gets the largest belief change of the last inference iteration
+	double getMaxDiff() const {
+		return finalDiff;
+	}
+
+	/// Gets the number of inference iterations, or 0 if inference was not run
+	size_t getIterations() const {
+		return hasBeliefs() ? algorithm->Iterations() : 0;
+	}
+
+	/// Gets the network of the scene
+	const dai::FactorGraph& network() const {
+		return graph;
+	}
+
+	/// Gets the belief of the variable \c v. Inference must have been run.
+	dai::Factor belief(const dai::Var& v) const {
+		return algorithm->belief(v);
+	}
+
+	/// Gets the belief of the variables \c vs. Inference must have been run.
+	dai::Factor belief(const dai::VarSet& vs) const {
+		return algorithm->belief(vs);
+	}
+
+	/// Gets the cached probability that node \c i is in state 1, or 0 if inference was not run
+	double nodeProbability(const size_t& i) const {
+		return nodeBeliefs[i];
+	}
+
+	/// Gets the cached probability that both nodes of the <object, action> factor \c k are in state 1
+	double relationProbability(const size_t& k) const {
+		return relationBeliefs[k];
+	}
+
+	/// Determines whether factor \c k connects an object node to an action node
+	bool isRelation(const size_t& k) const {
+		return (relationFactors[k] != 0);
+	}
+
+
+private:
+	/// The object-action intention network of the scene
+	dai::FactorGraph graph;
+
+	/// The inference algorithm, kept for beliefs that are not cached
+	dai::InfAlg* algorithm;
+
+	/// Probability of state 1 of every object and action node, indexed by node
+	std::vector<double> nodeBeliefs;
+
+	/// Probability of the joint state (1, 1) of every <object, action> factor, indexed by factor
+	std::vector<double> relationBeliefs;
+
+	/// Marks the factors that connect an object node to an action node
+	std::vector<char> relationFactors;
+
+	/// Largest belief change of the last inference iteration
+	double finalDiff;
+
+	/// Indicates whether the beliefs converged
+	bool isConverged;
+
+
+	/// Finds the factors that connect an object node to an action node
+	void findRelations() {
+		nodeBeliefs.assign(graph.nrVars(), 0.);
+		relationBeliefs.assign(graph.nrFactors(), 0.);
+		relationFactors.assign(graph.nrFactors(), 0);
+
+		for (size_t k = 0; k < graph.nrFactors(); k++) {
+			const dai::VarSet& vars = graph.factor(k).vars();
+
+			if (vars.size() == 2) {
+				dai::NodeType first = vars.elements()[0].type();
+				dai::NodeType second = vars.elements()[1].type();
+
+				if ((first == dai::ACTION && second == dai::OBJECT) || (first == dai::OBJECT && second == dai::ACTION)) {
+					relationFactors[k] = 1;
+				}
+			}
+		}
+	}
+
+	/// Runs inference and caches the beliefs that the queries are built from
+	void run(const dai::PropertySet& props) {
+		algorithm = dai::newInfAlg("BP", graph, props);
+		algorithm->init();
+		finalDiff = algorithm->run();
+		isConverged = (finalDiff <= props.getAs<double>("tol"));
+
+		const std::vector<dai::Var>& nodes = graph.vars();
+
+		for (size_t i = 0; i < nodes.size(); i++) {
+			if (nodes[i].type() == dai::ACTION || nodes[i].type() == dai::OBJECT) {
+				nodeBeliefs[i] = algorithm->belief(nodes[i])[1];
+			}
+		}
+
+		for (size_t k = 0; k < graph.nrFactors(); k++) {
+			if (relationFactors[k]) {
+				relationBeliefs[k] = algorithm->belief(graph.factor(k).vars())[3];
+			}
+		}
+	}
+
+};
+
+
+/// Shared handle to the inference results of a scene
+typedef boost::shared_ptr<const SceneInference> SceneInferencePtr;
+
+
+} /* oar */
+
+#endif /* __SCENE_INFERENCE_H__ */
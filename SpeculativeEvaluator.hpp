@@ -0,0 +1,203 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file SpeculativeEvaluator.hpp
+ *	\brief Computes the outcomes of both answers to a query while the user is answering it
+ *	\author	Kester Duncan
+ */
+#ifndef __SPECULATIVE_EVALUATOR_H__
+#define __SPECULATIVE_EVALUATOR_H__
+
+#include <cstdlib>
+#include <vector>
+#include <boost/bind/bind.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include "QueryState.hpp"
+
+
+namespace oar {
+
+
+/**
+ * \brief Computes the outcomes of both answers to the proposed query in the background
+ *
+ * While the question is displayed, a worker thread applies a "no" and then a "yes" to
+ * copies of the session state and selects the query that would follow each of them.
+ * When the real answer arrives, its outcome is taken as soon as it is ready, so the
+ * next question can be shown without waiting for pruning and ranking.
+ */
+class SpeculativeEvaluator : private boost::noncopyable {
+public:
+	/// Default constructor
+	SpeculativeEvaluator() : active(false), cancelled(false), policy(NULL), plannedQueries(NULL), lookahead(NULL) {
+		done[0] = done[1] = false;
+		recognized[0] = recognized[1] = false;
+	}
+
+	/// Abandons any speculation in progress
+	~SpeculativeEvaluator() {
+		cancel();
+	}
+
+	/**
+	 * \brief Starts computing both outcomes of answering the current query of \c state
+	 *
+	 * \c policy, \c planned and \c queryLookahead are used to select the following query,
+	 * as in QueryState::select(); they must not change until the speculation is taken or
+	 * cancelled.
+	 */
+	void start(const QueryState& state, const QueryPolicy* queryPolicy, const std::vector<Query>& planned,
+			QueryLookahead* queryLookahead) {
+
+		cancel();
+
+		base = state;
+		policy = queryPolicy;
+		plannedQueries = &planned;
+		lookahead = queryLookahead;
+		done[0] = done[1] = false;
+		cancelled = false;
+		active = true;
+
+		worker = boost::thread(boost::bind(&SpeculativeEvaluator::run, this));
+	}
+
+	/**
+	 * \brief Takes the outcome of answering \c answered with \c wasSelected, waiting for
+	 * it if it is still being computed
+	 * \param[out] state The state after the answer
+	 * \param[out] intentionRecognized Whether the answer recognizes the intention
+	 * \return False if no speculation was made for \c answered, in which case the
+	 * answer has to be applied directly
+	 */
+	bool take(const Query& answered, const bool& wasSelected, QueryState& state, bool& intentionRecognized) {
+		boost::mutex::scoped_lock lock(mutex);
+		const int branch = wasSelected ? 1 : 0;
+
+		if (!active || base.currentQuery.index != answered.index) {
+			return false;
+		}
+
+		while (!done[branch]) {
+			ready.wait(lock);
+		}
+
+		state = outcomes[branch];
+		intentionRecognized = recognized[branch];
+
+		// The other outcome is no longer needed
+		cancelled = true;
+		active = false;
+
+		return true;
+	}
+
+	/**
+	 * \brief Abandons the speculation in progress, waiting for the worker to stop
+	 */
+	void cancel() {
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			cancelled = true;
+			active = false;
+		}
+
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+
+
+private:
+	/// The state the speculation starts from
+	QueryState base;
+
+	/// The state after a "no" (0) and after a "yes" (1)
+	QueryState outcomes[2];
+
+	/// Whether each outcome has been computed
+	bool done[2];
+
+	/// Whether each answer recognizes the intention
+	bool recognized[2];
+
+	/// Whether a speculation is in progress and its outcomes have not been taken
+	bool active;
+
+	/// Whether the remaining outcomes should not be computed
+	bool cancelled;
+
+	const QueryPolicy* policy;
+	const std::vector<Query>* plannedQueries;
+	QueryLookahead* lookahead;
+
+	boost::thread worker;
+	boost::mutex mutex;
+	boost::condition_variable ready;
+
+
+	/// Computes the outcome of a "no" and then of a "yes"
+	void run() {
+		for (int branch = 0; branch < 2; branch++) {
+			{
+				boost::mutex::scoped_lock lock(mutex);
+				if (cancelled) {
+					return;
+				}
+			}
+
+			QueryState outcome = base;
+			bool intentionRecognized = outcome.applyAnswer(branch == 1, policy);
+
+			if (!intentionRecognized) {
+				outcome.select(policy, *plannedQueries, lookahead);
+			}
+
+			{
+				boost::mutex::scoped_lock lock(mutex);
+				outcomes[branch] = outcome;
+				recognized[branch] = intentionRecognized;
+				done[branch] = true;
+			}
+			ready.notify_all();
+		}
+	}
+
+};
+
+
+} /* oar */
+
+#endif /* __SPECULATIVE_EVALUATOR_H__ */
@@ -0,0 +1,366 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file TemplateJournal.hpp
+ *	\brief Append-only journal of template updates, compacted into the template map in the background
+ *	\author	Kester Duncan
+ */
+#ifndef __TEMPLATE_JOURNAL_H__
+#define __TEMPLATE_JOURNAL_H__
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/filesystem.hpp>
+#include "ObjectActionMap.h"
+#include "TemplateUpdateBuffer.hpp"
+
+
+namespace oar {
+
+
+/**
+ * \brief Records the template updates of every session in an append-only journal next
+ * to the template map, instead of rewriting the whole map after each session
+ *
+ * The journal of "ObjectActionMap.map" is "ObjectActionMap.map.journal". Each session
+ * appends one line per changed <object, action> template,
+ *
+ *     u <object index> <action index> <delta> <timestamp>
+ *
+ * followed by the line "s <timestamp>", which commits the session. On load, the map is
+ * read and the committed sessions are replayed onto it in order; a session cut short
+ * by a crash has no commit line and is ignored. The journal doubles as an audit trail
+ * of what was learned and when.
+ *
+ * Once \c sessionsPerCompaction sessions have been journaled, the journal is set aside
+ * and a background thread writes the current map to a temporary file, creates the
+ * marker file "ObjectActionMap.map.journal.compacted", renames the temporary file over
+ * the map and deletes the set-aside journal and the marker. Sessions that end meanwhile
+ * go to a new journal. The marker records that the temporary file, and so the map once
+ * renamed, already holds the set-aside sessions. If the process stops before the marker
+ * is created, the set-aside journal is replayed and the compaction redone on the next
+ * load; if it stops after, the rename is completed if needed and the set-aside journal
+ * is deleted without being replayed, so no session is ever applied twice.
+ */
+class TemplateJournal : private boost::noncopyable {
+public:
+	/**
+	 * \brief Constructs the journal of the map file \c mapName, compacted every
+	 * \c sessionsPerCompaction sessions; 0 never compacts automatically
+	 */
+	explicit TemplateJournal(const std::string& mapName = "ObjectActionMap.map", const size_t& sessionsPerCompaction = 32) :
+		mapFileName(mapName), journalFileName(mapName + ".journal"), compactingFileName(mapName + ".journal.compacting"),
+		compactedFileName(mapName + ".journal.compacted"), tempFileName(mapName + ".tmp"), sessionsPerCompaction(sessionsPerCompaction), numSessions(0) {}
+
+	/// Waits for a compaction in progress
+	~TemplateJournal() {
+		wait();
+	}
+
+	/**
+	 * \brief Reads the map into \c oaMap and replays the journaled sessions onto it
+	 */
+	void load(ObjectActionMap& oaMap) {
+		wait();
+		recoverCompaction();
+		oaMap.readMap(mapFileName);
+
+		// Redo a compaction that was interrupted before the new map was complete
+		if (boost::filesystem::exists(compactingFileName)) {
+			replay(compactingFileName, oaMap);
+			commitMap(oaMap);
+		}
+
+		numSessions = replay(journalFileName, oaMap);
+	}
+
+	/**
+	 * \brief Appends the updates of a session to the journal
+	 * \return False if the journal could not be written
+	 */
+	bool append(const TemplateUpdateBuffer& sessionUpdates) {
+		if (sessionUpdates.empty()) {
+			return true;
+		}
+
+		std::ofstream outFile (journalFileName.c_str(), std::ios::out | std::ios::app);
+
+		if (!outFile.is_open()) {
+			std::cerr << "TemplateJournal: Unable to open file " << journalFileName << " for writing!\n";
+			return false;
+		}
+
+		const long timestamp = static_cast<long>(time(NULL));
+		const std::vector<TemplateUpdateBuffer::TemplateUpdate>& updates = sessionUpdates.getUpdates();
+
+		// Deltas are written with enough digits to be read back exactly
+		outFile << std::setprecision(17);
+
+		for (size_t i = 0; i < updates.size(); i++) {
+			outFile << "u " << updates[i].objectIdx << " " << updates[i].actionIdx << " " << updates[i].delta << " "
+				<< timestamp << "\n";
+		}
+		outFile << "s " << timestamp << "\n";
+		outFile.close();
+
+		if (outFile.fail()) {
+			std::cerr << "TemplateJournal: Unable to write to " << journalFileName << "!\n";
+			return false;
+		}
+
+		numSessions++;
+		return true;
+	}
+
+	/// Indicates whether enough sessions have been journaled to compact the journal
+	bool needsCompaction() const {
+		return (sessionsPerCompaction > 0 && numSessions >= sessionsPerCompaction);
+	}
+
+	/**
+	 * \brief Starts folding the journal into the map in the background. \c current must
+	 * be the map as loaded, with every journaled session applied.
+	 */
+	void compact(const ObjectActionMap& current) {
+		wait();
+
+		if (!setAside()) {
+			return;
+		}
+		numSessions = 0;
+
+		compactor = boost::thread(boost::bind(&TemplateJournal::runCompaction, this, current));
+	}
+
+	/// Waits for a compaction in progress
+	void wait() {
+		if (compactor.joinable()) {
+			compactor.join();
+		}
+	}
+
+	/// Gets the number of sessions journaled since the last compaction
+	size_t getNumSessions() const {
+		return numSessions;
+	}
+
+	/// Gets the name of the map file
+	const std::string& getMapFileName() const {
+		return mapFileName;
+	}
+
+	/// Gets the name of the journal file
+	const std::string& getJournalFileName() const {
+		return journalFileName;
+	}
+
+
+private:
+	/// Map file that the journal belongs to
+	std::string mapFileName;
+
+	/// Journal file that sessions are appended to
+	std::string journalFileName;
+
+	/// Journal file that is being folded into the map
+	std::string compactingFileName;
+
+	/// Marker file indicating that \c tempFileName holds the sessions of \c compactingFileName
+	std::string compactedFileName;
+
+	/// File the new map is written to before it replaces the map
+	std::string tempFileName;
+
+	/// Number of sessions after which the journal is compacted
+	size_t sessionsPerCompaction;
+
+	/// Number of sessions in the journal
+	size_t numSessions;
+
+	/// Thread that folds the journal into the map
+	boost::thread compactor;
+
+
+	/**
+	 * \brief Applies the committed sessions of the journal file \c fileName to \c oaMap
+	 * \return The number of sessions applied
+	 */
+	static size_t replay(const std::string& fileName, ObjectActionMap& oaMap) {
+		std::ifstream inFile (fileName.c_str(), std::ios::in);
+		TemplateUpdateBuffer pending;
+		std::string tag;
+		size_t objectIdx, actionIdx;
+		double delta;
+		long timestamp;
+		size_t sessions = 0;
+
+		while (inFile >> tag) {
+			if (tag == "u" && inFile >> objectIdx >> actionIdx >> delta >> timestamp) {
+				pending.add(objectIdx, actionIdx, delta);
+
+			} else if (tag == "s" && inFile >> timestamp) {
+				// Apply the session exactly as the recognizer applied it when the session ended
+				pending.apply(oaMap);
+				sessions++;
+
+			} else {
+				std::cerr << "TemplateJournal: Ignoring the rest of " << fileName << ", which is malformed\n";
+				break;
+			}
+		}
+
+		return sessions;
+	}
+
+	/**
+	 * \brief Moves the journal to the set-aside journal, adding to it if one is left over
+	 * \return False if the journal could not be moved
+	 */
+	bool setAside() {
+		boost::system::error_code ec;
+
+		if (!boost::filesystem::exists(journalFileName)) {
+			return true;
+		}
+
+		if (boost::filesystem::exists(compactingFileName)) {
+			std::ifstream inFile (journalFileName.c_str(), std::ios::in | std::ios::binary);
+			std::ofstream outFile (compactingFileName.c_str(), std::ios::out | std::ios::app | std::ios::binary);
+
+			outFile << inFile.rdbuf();
+			inFile.close();
+			outFile.close();
+
+			boost::filesystem::remove(journalFileName, ec);
+		} else {
+			boost::filesystem::rename(journalFileName, compactingFileName, ec);
+		}
+
+		if (ec) {
+			std::cerr << "TemplateJournal: Unable to set aside " << journalFileName << ": " << ec.message() << "\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * \brief Replaces the map file with \c oaMap, which holds the sessions of the set-aside
+	 * journal, through a temporary file, then deletes the set-aside journal
+	 * \return False if the map was left as it was, along with the set-aside journal
+	 */
+	bool commitMap(ObjectActionMap& oaMap) const {
+		boost::system::error_code ec;
+
+		if (!oaMap.writeMap(tempFileName)) {
+			std::cerr << "TemplateJournal: Unable to write " << tempFileName << "\n";
+			boost::filesystem::remove(tempFileName, ec);
+			return false;
+		}
+
+		// From here on the set-aside sessions are in the new map and must not be replayed again
+		std::ofstream marker (compactedFileName.c_str(), std::ios::out | std::ios::trunc);
+		marker.close();
+
+		if (marker.fail()) {
+			std::cerr << "TemplateJournal: Unable to create " << compactedFileName << "\n";
+			boost::filesystem::remove(tempFileName, ec);
+			return false;
+		}
+
+		boost::filesystem::rename(tempFileName, mapFileName, ec);
+
+		if (ec) {
+			std::cerr << "TemplateJournal: Unable to replace " << mapFileName << ": " << ec.message() << "\n";
+			boost::filesystem::remove(compactedFileName, ec);
+			boost::filesystem::remove(tempFileName, ec);
+			return false;
+		}
+
+		finishCompaction();
+		return true;
+	}
+
+	/// Deletes the set-aside journal, which the map now holds, and then the marker
+	void finishCompaction() const {
+		boost::system::error_code ec;
+
+		boost::filesystem::remove(compactingFileName, ec);
+		boost::filesystem::remove(compactedFileName, ec);
+	}
+
+	/**
+	 * \brief Completes a compaction that was interrupted after the new map was written,
+	 * and discards the temporary file of one that was interrupted before
+	 */
+	void recoverCompaction() const {
+		boost::system::error_code ec;
+
+		if (!boost::filesystem::exists(compactedFileName)) {
+			boost::filesystem::remove(tempFileName, ec);
+			return;
+		}
+
+		// Without the temporary file, it has already replaced the map
+		if (boost::filesystem::exists(tempFileName)) {
+			boost::filesystem::rename(tempFileName, mapFileName, ec);
+
+			if (ec) {
+				std::cerr << "TemplateJournal: Unable to replace " << mapFileName << ": " << ec.message() << "\n";
+				boost::filesystem::remove(compactedFileName, ec);
+				boost::filesystem::remove(tempFileName, ec);
+				return;
+			}
+		}
+
+		finishCompaction();
+	}
+
+	/// Writes \c snapshot as the new map and deletes the set-aside journal
+	void runCompaction(ObjectActionMap snapshot) {
+		commitMap(snapshot);
+	}
+
+};
+
+
+} /* oar */
+
+#endif /* __TEMPLATE_JOURNAL_H__ */
@@ -0,0 +1,137 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file TemplateUpdateBuffer.hpp
+ *	\brief Per-session buffer of template updates applied to the object-action map in one batch
+ *	\author	Kester Duncan
+ */
+#ifndef __TEMPLATE_UPDATE_BUFFER_H__
+#define __TEMPLATE_UPDATE_BUFFER_H__
+
+#include <cstdlib>
+#include <vector>
+#include "ObjectActionMap.h"
+
+
+namespace oar {
+
+
+/**
+ * \brief Accumulates the changes to the <object, action> template compatibilities that
+ * are learned during a session
+ *
+ * Answers only record a delta, so the map is not written while the user is being
+ * questioned. The deltas of the same pair are summed and the whole buffer is applied
+ * to the map when the session ends.
+ */
+class TemplateUpdateBuffer {
+public:
+	/// Pending change of a single template
+	struct TemplateUpdate {
+		size_t objectIdx;
+		size_t actionIdx;
+		double delta;
+
+		TemplateUpdate(const size_t& o, const size_t& a, const double& d) : objectIdx(o), actionIdx(a), delta(d) {}
+	};
+
+	/// Default constructor
+	TemplateUpdateBuffer() {}
+
+	/**
+	 * \brief Adds \c delta to the pending change of the template of the object \c objectIdx
+	 * and the action \c actionIdx
+	 */
+	void add(const size_t& objectIdx, const size_t& actionIdx, const double& delta) {
+		for (size_t i = 0; i < updates.size(); i++) {
+			if (updates[i].objectIdx == objectIdx && updates[i].actionIdx == actionIdx) {
+				updates[i].delta += delta;
+				return;
+			}
+		}
+
+		updates.push_back(TemplateUpdate(objectIdx, actionIdx, delta));
+	}
+
+	/// Indicates whether there are no pending changes
+	bool empty() const {
+		return updates.empty();
+	}
+
+	/// Number of templates with pending changes
+	size_t size() const {
+		return updates.size();
+	}
+
+	/// Gets the pending changes
+	const std::vector<TemplateUpdate>& getUpdates() const {
+		return updates;
+	}
+
+	/// Discards the pending changes
+	void clear() {
+		updates.clear();
+	}
+
+	/**
+	 * \brief Applies the pending changes to \c oaMap and clears the buffer
+	 *
+	 * The changed templates are then normalized, as they are when the map is written
+	 * and read back, so that a map kept in memory across sessions matches the map
+	 * rebuilt from the file and the template journal.
+	 */
+	void apply(ObjectActionMap& oaMap) {
+		for (size_t i = 0; i < updates.size(); i++) {
+			if (updates[i].delta != 0.) {
+				oaMap.updateMap(updates[i].objectIdx, updates[i].actionIdx, updates[i].delta);
+			}
+		}
+		for (size_t i = 0; i < updates.size(); i++) {
+			if (updates[i].delta != 0.) {
+				oaMap.normalizeTemplate(updates[i].objectIdx, updates[i].actionIdx);
+			}
+		}
+
+		updates.clear();
+	}
+
+
+private:
+	/// Pending changes, one per template
+	std::vector<TemplateUpdate> updates;
+
+};
+
+
+} /* oar */
+
+#endif /* __TEMPLATE_UPDATE_BUFFER_H__ */
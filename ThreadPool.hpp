@@ -0,0 +1,240 @@
+/**
+ * Software License Agreement (BSD License)
+ *
+ *  Object Action Recognition
+ *  Copyright (c) 2013, Kester Duncan
+ *
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ *	\file ThreadPool.hpp
+ *	\brief Fixed-size pool of worker threads
+ *	\author	Kester Duncan
+ */
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <cstdlib>
+#include <deque>
+#include <boost/bind/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+
+namespace oar {
+
+
+/**
+ * \brief Fixed-size pool of worker threads
+ *
+ * Tasks are executed in the order in which they are scheduled. The workers are
+ * created once and live as long as the pool, so scheduling work per interaction
+ * does not pay for thread creation.
+ */
+class ThreadPool : private boost::noncopyable {
+public:
+	/// A unit of work
+	typedef boost::function<void ()> Task;
+
+	/// Creates a pool with \c numThreads workers; zero uses one worker per hardware thread
+	explicit ThreadPool(size_t numThreads = 0) : pending(0), stopping(false) {
+		if (numThreads == 0) {
+			numThreads = boost::thread::hardware_concurrency();
+		}
+		if (numThreads == 0) {
+			numThreads = 1;
+		}
+
+		for (size_t i = 0; i < numThreads; i++) {
+			workers.create_thread(boost::bind(&ThreadPool::workerLoop, this));
+		}
+		numWorkers = numThreads;
+	}
+
+	/// Finishes the scheduled tasks and stops the workers
+	~ThreadPool() {
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			stopping = true;
+		}
+		taskReady.notify_all();
+		workers.join_all();
+	}
+
+	/// Number of worker threads
+	size_t size() const {
+		return numWorkers;
+	}
+
+	/// Schedules \c task for execution
+	void schedule(const Task& task) {
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			tasks.push_back(task);
+			pending++;
+		}
+		taskReady.notify_one();
+	}
+
+	/// Blocks until every scheduled task has finished
+	void wait() {
+		boost::mutex::scoped_lock lock(mutex);
+
+		while (pending > 0) {
+			allDone.wait(lock);
+		}
+	}
+
+	/**
+	 * \brief Calls \c body(i) for every i in [0, n), split into contiguous ranges across
+	 * the workers, and waits for these ranges to complete
+	 *
+	 * Only the ranges of this call are waited for, and the calling thread executes queued
+	 * tasks while it waits, so parallelFor can be called concurrently and from within a
+	 * task of the pool.
+	 */
+	template <typename Body>
+	void parallelFor(const size_t& n, Body body) {
+		if (n == 0) {
+			return;
+		}
+
+		size_t numChunks = (n < numWorkers) ? n : numWorkers;
+		size_t chunkSize = (n + numChunks - 1) / numChunks;
+		size_t remaining = (n + chunkSize - 1) / chunkSize;
+
+		for (size_t begin = 0; begin < n; begin += chunkSize) {
+			size_t end = (begin + chunkSize < n) ? begin + chunkSize : n;
+			schedule(boost::bind(&ThreadPool::runRange<Body>, this, body, begin, end, &remaining));
+		}
+
+		boost::mutex::scoped_lock lock(mutex);
+
+		while (remaining > 0) {
+			if (tasks.empty()) {
+				rangeDone.wait(lock);
+				continue;
+			}
+
+			Task task = tasks.front();
+			tasks.pop_front();
+
+			lock.unlock();
+			task();
+			lock.lock();
+
+			finishTask();
+		}
+	}
+
+
+private:
+	/// Worker threads
+	boost::thread_group workers;
+
+	/// Number of worker threads
+	size_t numWorkers;
+
+	/// Tasks waiting to be executed
+	std::deque<Task> tasks;
+
+	/// Number of tasks scheduled but not yet finished
+	size_t pending;
+
+	/// Indicates that the workers should exit once the queue is empty
+	bool stopping;
+
+	/// Guards the task queue and counters
+	boost::mutex mutex;
+
+	/// Signalled when a task is scheduled or the pool is stopping
+	boost::condition_variable taskReady;
+
+	/// Signalled when the last pending task finishes
+	boost::condition_variable allDone;
+
+	/// Signalled when a range of a parallelFor call finishes
+	boost::condition_variable rangeDone;
+
+
+	/// Executes \c body over the range [begin, end) and counts it off \c remaining
+	template <typename Body>
+	void runRange(Body body, size_t begin, size_t end, size_t* remaining) {
+		for (size_t i = begin; i < end; i++) {
+			body(i);
+		}
+
+		boost::mutex::scoped_lock lock(mutex);
+		(*remaining)--;
+		rangeDone.notify_all();
+	}
+
+	/// Counts off a finished task; called with \c mutex locked
+	void finishTask() {
+		pending--;
+
+		if (pending == 0) {
+			allDone.notify_all();
+		}
+	}
+
+	/// Executes tasks until the pool is stopped
+	void workerLoop() {
+		while (true) {
+			Task task;
+
+			{
+				boost::mutex::scoped_lock lock(mutex);
+
+				while (tasks.empty() && !stopping) {
+					taskReady.wait(lock);
+				}
+				if (tasks.empty()) {
+					return;
+				}
+
+				task = tasks.front();
+				tasks.pop_front();
+			}
+
+			task();
+
+			{
+				boost::mutex::scoped_lock lock(mutex);
+				finishTask();
+			}
+		}
+	}
+
+};
+
+
+} /* oar */
+
+#endif /* __THREAD_POOL_H__ */